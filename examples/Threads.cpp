@@ -0,0 +1,441 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014 Jonathan Young
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Runs several independent main windows at the same time, each on its own thread with its own renderer, while the main thread posts updates to all of them.
+// There is no window or GL context: NanoVG draws to a backend that discards everything. Generate with "premake5 --tsan gmake" to build with ThreadSanitizer, which reports any state shared between the instances.
+// Usage: example_threads [threads] [frames]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <wz.h>
+#include <wz_renderer_nanovg.h>
+#include <nanovg.h>
+
+#define MAX_THREADS 64
+#define WINDOW_WIDTH 640
+#define WINDOW_HEIGHT 480
+
+/*
+================================================================================
+
+HEADLESS NANOVG BACKEND
+
+================================================================================
+*/
+
+// Per context, so the instances don't share texture ids.
+struct HeadlessContext
+{
+	int nTextures;
+};
+
+static int HeadlessCreate(void *)
+{
+	return 1;
+}
+
+static int HeadlessCreateTexture(void *userPtr, int, int, int, int, const unsigned char *)
+{
+	return ++((HeadlessContext *)userPtr)->nTextures;
+}
+
+static int HeadlessDeleteTexture(void *, int)
+{
+	return 1;
+}
+
+static int HeadlessUpdateTexture(void *, int, int, int, int, int, const unsigned char *)
+{
+	return 1;
+}
+
+static int HeadlessGetTextureSize(void *, int, int *w, int *h)
+{
+	*w = *h = 512;
+	return 1;
+}
+
+static void HeadlessViewport(void *, int, int) {}
+static void HeadlessCancel(void *) {}
+static void HeadlessFlush(void *) {}
+static void HeadlessFill(void *, NVGpaint *, NVGscissor *, float, const float *, const NVGpath *, int) {}
+static void HeadlessStroke(void *, NVGpaint *, NVGscissor *, float, float, const NVGpath *, int) {}
+static void HeadlessTriangles(void *, NVGpaint *, NVGscissor *, const NVGvertex *, int) {}
+
+static void HeadlessDelete(void *userPtr)
+{
+	free(userPtr);
+}
+
+static NVGcontext *HeadlessCreateContext(int)
+{
+	NVGparams params;
+	memset(&params, 0, sizeof(params));
+	params.userPtr = calloc(1, sizeof(HeadlessContext));
+	params.edgeAntiAlias = 1;
+	params.renderCreate = HeadlessCreate;
+	params.renderCreateTexture = HeadlessCreateTexture;
+	params.renderDeleteTexture = HeadlessDeleteTexture;
+	params.renderUpdateTexture = HeadlessUpdateTexture;
+	params.renderGetTextureSize = HeadlessGetTextureSize;
+	params.renderViewport = HeadlessViewport;
+	params.renderCancel = HeadlessCancel;
+	params.renderFlush = HeadlessFlush;
+	params.renderFill = HeadlessFill;
+	params.renderStroke = HeadlessStroke;
+	params.renderTriangles = HeadlessTriangles;
+	params.renderDelete = HeadlessDelete;
+	return nvgCreateInternal(&params);
+}
+
+static void HeadlessDeleteContext(NVGcontext *context)
+{
+	nvgDeleteInternal(context);
+}
+
+/*
+================================================================================
+
+THREADS
+
+================================================================================
+*/
+
+typedef void (*ThreadFunction)(void *data);
+
+struct ThreadStart
+{
+	ThreadFunction function;
+	void *data;
+};
+
+#ifdef _WIN32
+typedef HANDLE Thread;
+
+static DWORD WINAPI ThreadMain(LPVOID param)
+{
+	ThreadStart *start = (ThreadStart *)param;
+	start->function(start->data);
+	return 0;
+}
+
+static bool StartThread(Thread *thread, ThreadStart *start)
+{
+	*thread = CreateThread(NULL, 0, ThreadMain, start, 0, NULL);
+	return *thread != NULL;
+}
+
+static void JoinThread(Thread thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+static void YieldThread()
+{
+	Sleep(0);
+}
+#else
+typedef pthread_t Thread;
+
+static void *ThreadMain(void *param)
+{
+	ThreadStart *start = (ThreadStart *)param;
+	start->function(start->data);
+	return NULL;
+}
+
+static bool StartThread(Thread *thread, ThreadStart *start)
+{
+	return pthread_create(thread, NULL, ThreadMain, start) == 0;
+}
+
+static void JoinThread(Thread thread)
+{
+	pthread_join(thread, NULL);
+}
+
+static void YieldThread()
+{
+	sched_yield();
+}
+#endif
+
+/*
+================================================================================
+
+INSTANCE
+
+================================================================================
+*/
+
+// One main window and renderer, only touched by its own thread except for status and the flags.
+class Instance
+{
+public:
+	Instance() : index(0), nFrames(0), status(NULL), mainWindow(NULL), ready(0), finished(0), posterStopped(0), nClicks(0), nExpectedClicks(0), error(NULL) {}
+
+	static void run(void *data)
+	{
+		((Instance *)data)->run();
+	}
+
+	void onButtonClicked(wz::Event)
+	{
+		nClicks++;
+	}
+
+	int index;
+	int nFrames;
+
+	// Posted to by the main thread once ready is set.
+	wz::Label *status;
+	wz::MainWindow *mainWindow;
+
+	volatile long ready;
+	volatile long finished;
+
+	// Set by the main thread when it has stopped posting, so the main window can be destroyed.
+	volatile long posterStopped;
+
+	int nClicks;
+	int nExpectedClicks;
+	const char *error;
+
+private:
+	void click(wz::Widget *widget)
+	{
+		const wz::Rect rect = widget->getAbsoluteRect();
+		const int x = rect.x + rect.w / 2;
+		const int y = rect.y + rect.h / 2;
+		mainWindow->mouseMove(x, y, 0, 0);
+		mainWindow->mouseButtonDown(1, x, y);
+		mainWindow->mouseButtonUp(1, x, y);
+	}
+
+	void run()
+	{
+		wz::NVGRenderer *renderer = new wz::NVGRenderer(HeadlessCreateContext, HeadlessDeleteContext, 0, "../examples/data", "DejaVuSans", 16.0f);
+
+		if (renderer->getError())
+		{
+			fprintf(stderr, "Instance %d: %s\n", index, renderer->getError());
+			error = "error creating the renderer";
+			WZ_ATOMIC_STORE(&ready, 1);
+			WZ_ATOMIC_STORE(&finished, 1);
+			delete renderer;
+			return;
+		}
+
+		mainWindow = new wz::MainWindow(renderer, wz::MainWindowFlags::DockingEnabled | wz::MainWindowFlags::MenuEnabled);
+		mainWindow->setSize(WINDOW_WIDTH, WINDOW_HEIGHT);
+		mainWindow->createMenuButton("File");
+
+		wz::StackLayout *layout = new wz::StackLayout(wz::StackLayoutDirection::Vertical, 4);
+		layout->setStretch(wz::Stretch::All);
+		mainWindow->add(layout);
+
+		wz::Button *button = new wz::Button("Click me");
+		button->addEventHandler(wz::EventType::ButtonClicked, this, &Instance::onButtonClicked);
+		layout->add(button);
+
+		wz::Label *frameLabel = new wz::Label;
+		layout->add(frameLabel);
+
+		status = new wz::Label("Waiting");
+		layout->add(status);
+
+		wz::TextEdit *textEdit = new wz::TextEdit(false, "Text");
+		layout->add(textEdit);
+
+		wz::Frame *immediateFrame = new wz::Frame;
+		immediateFrame->setStretch(wz::Stretch::All);
+		layout->add(immediateFrame);
+
+		wz::im::Context *context = new wz::im::Context(immediateFrame);
+		bool checked = false;
+		mainWindow->drawFrame();
+		WZ_ATOMIC_STORE(&ready, 1);
+
+		for (int frame = 0; frame < nFrames; frame++)
+		{
+			frameLabel->setTextf("Instance %d, frame %d", index, frame);
+
+			// Input.
+			click(button);
+			nExpectedClicks++;
+			mainWindow->mouseWheelMove(0, frame % 2 ? 1 : -1);
+			mainWindow->setKeyboardFocusWidget(textEdit);
+			mainWindow->textInput("a");
+			mainWindow->keyDown(wz::Key::Backspace);
+			mainWindow->keyUp(wz::Key::Backspace);
+
+			// Create and destroy a window, so widgets go through the pool and font faces are interned.
+			if (frame % 8 == 0)
+			{
+				wz::Window *window = new wz::Window("Window");
+				window->setRect(100 + index * 4, 100, 200, 150);
+				wz::Label *label = new wz::Label("Label");
+				label->setFontFace(frame % 16 ? "DejaVuSans" : "visitor1");
+				window->add(label);
+				mainWindow->add(window);
+				mainWindow->drawFrame();
+				mainWindow->remove(window);
+				delete label;
+				delete window;
+			}
+
+			// The immediate-mode facade.
+			context->begin();
+			context->beginStack(wz::StackLayoutDirection::Horizontal, 4);
+			context->label(frame % 2 ? "Odd" : "Even");
+			context->checkBox("Check", &checked);
+			context->endStack();
+			context->end();
+
+			mainWindow->drawFrame();
+		}
+
+		if (nClicks != nExpectedClicks)
+		{
+			error = "button clicks were lost";
+		}
+
+		// Wait for the main thread to stop posting before destroying the main window.
+		WZ_ATOMIC_STORE(&finished, 1);
+
+		while (!WZ_ATOMIC_LOAD(&posterStopped))
+		{
+			YieldThread();
+		}
+
+		// The context must be destroyed before the main window, which destroys all of its widgets.
+		delete context;
+		mainWindow->drawFrame();
+		delete mainWindow;
+		delete renderer;
+	}
+};
+
+int main(int argc, char **argv)
+{
+	const int nThreads = argc > 1 ? atoi(argv[1]) : 8;
+	const int nFrames = argc > 2 ? atoi(argv[2]) : 200;
+
+	if (nThreads < 1 || nThreads > MAX_THREADS || nFrames < 1)
+	{
+		fprintf(stderr, "Usage: example_threads [threads (1-%d)] [frames]\n", MAX_THREADS);
+		return 1;
+	}
+
+	static Instance instances[MAX_THREADS];
+	static ThreadStart starts[MAX_THREADS];
+	static Thread threads[MAX_THREADS];
+
+	for (int i = 0; i < nThreads; i++)
+	{
+		instances[i].index = i;
+		instances[i].nFrames = nFrames;
+		starts[i].function = Instance::run;
+		starts[i].data = &instances[i];
+
+		if (!StartThread(&threads[i], &starts[i]))
+		{
+			fprintf(stderr, "Error creating thread %d\n", i);
+			return 1;
+		}
+	}
+
+	// Post to every instance until they have all finished. Posting is the only thing another thread may do with a main window.
+	int nPosted = 0;
+
+	for (;;)
+	{
+		bool anyRunning = false;
+
+		for (int i = 0; i < nThreads; i++)
+		{
+			Instance &instance = instances[i];
+
+			if (!WZ_ATOMIC_LOAD(&instance.ready) || WZ_ATOMIC_LOAD(&instance.finished))
+				continue;
+
+			anyRunning = true;
+			char text[32];
+			sprintf(text, "Posted %d", nPosted);
+
+			if (instance.mainWindow->post(wz::Update::labelText(instance.status, text)))
+			{
+				nPosted++;
+			}
+		}
+
+		bool allFinished = true;
+
+		for (int i = 0; i < nThreads; i++)
+		{
+			if (!WZ_ATOMIC_LOAD(&instances[i].finished))
+			{
+				allFinished = false;
+				break;
+			}
+		}
+
+		if (allFinished)
+			break;
+
+		if (!anyRunning)
+		{
+			YieldThread();
+		}
+	}
+
+	for (int i = 0; i < nThreads; i++)
+	{
+		WZ_ATOMIC_STORE(&instances[i].posterStopped, 1);
+	}
+
+	int result = 0;
+
+	for (int i = 0; i < nThreads; i++)
+	{
+		JoinThread(threads[i]);
+
+		if (instances[i].error)
+		{
+			fprintf(stderr, "Instance %d: %s\n", i, instances[i].error);
+			result = 1;
+		}
+	}
+
+	printf("%d main windows ran %d frames each, %d updates posted\n", nThreads, nFrames, nPosted);
+	return result;
+}
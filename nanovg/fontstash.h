@@ -19,6 +19,8 @@
 #ifndef FONS_H
 #define FONS_H
 
+#include <stddef.h>
+
 #define FONS_INVALID -1
 
 enum FONSflags {
@@ -58,6 +60,9 @@ struct FONSparams {
 	void (*renderUpdate)(void* uptr, int* rect, const unsigned char* data);
 	void (*renderDraw)(void* uptr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts);
 	void (*renderDelete)(void* uptr);
+	// Optional. Allocates if ptr is NULL, frees if size is 0, otherwise reallocates. Uses the C runtime if NULL.
+	void* (*memRealloc)(void* uptr, void* ptr, size_t size);
+	void* memUserPtr;
 };
 typedef struct FONSparams FONSparams;
 
@@ -392,6 +397,7 @@ typedef struct FONSatlasNode FONSatlasNode;
 
 struct FONSatlas
 {
+	const FONSparams* params;
 	int width, height;
 	FONSatlasNode* nodes;
 	int nnodes;
@@ -487,27 +493,39 @@ static unsigned int fons__decutf8(unsigned int* state, unsigned int* codep, unsi
 
 // Atlas based on Skyline Bin Packer by Jukka Jylänki
 
+static void* fons__realloc(const FONSparams* params, void* ptr, size_t size)
+{
+	if (params->memRealloc != NULL)
+		return params->memRealloc(params->memUserPtr, ptr, size);
+	if (size == 0) {
+		free(ptr);
+		return NULL;
+	}
+	return realloc(ptr, size);
+}
+
 static void fons__deleteAtlas(FONSatlas* atlas)
 {
 	if (atlas == NULL) return;
-	if (atlas->nodes != NULL) free(atlas->nodes);
-	free(atlas);
+	if (atlas->nodes != NULL) fons__realloc(atlas->params, atlas->nodes, 0);
+	fons__realloc(atlas->params, atlas, 0);
 }
 
-static FONSatlas* fons__allocAtlas(int w, int h, int nnodes)
+static FONSatlas* fons__allocAtlas(const FONSparams* params, int w, int h, int nnodes)
 {
 	FONSatlas* atlas = NULL;
 
 	// Allocate memory for the font stash.
-	atlas = (FONSatlas*)malloc(sizeof(FONSatlas));
+	atlas = (FONSatlas*)fons__realloc(params, NULL, sizeof(FONSatlas));
 	if (atlas == NULL) goto error;
 	memset(atlas, 0, sizeof(FONSatlas));
 
+	atlas->params = params;
 	atlas->width = w;
 	atlas->height = h;
 
 	// Allocate space for skyline nodes
-	atlas->nodes = (FONSatlasNode*)malloc(sizeof(FONSatlasNode) * nnodes);
+	atlas->nodes = (FONSatlasNode*)fons__realloc(params, NULL, sizeof(FONSatlasNode) * nnodes);
 	if (atlas->nodes == NULL) goto error;
 	memset(atlas->nodes, 0, sizeof(FONSatlasNode) * nnodes);
 	atlas->nnodes = 0;
@@ -532,7 +550,7 @@ static int fons__atlasInsertNode(FONSatlas* atlas, int idx, int x, int y, int w)
 	// Insert node
 	if (atlas->nnodes+1 > atlas->cnodes) {
 		atlas->cnodes = atlas->cnodes == 0 ? 8 : atlas->cnodes * 2;
-		atlas->nodes = (FONSatlasNode*)realloc(atlas->nodes, sizeof(FONSatlasNode) * atlas->cnodes);
+		atlas->nodes = (FONSatlasNode*)fons__realloc(atlas->params, atlas->nodes, sizeof(FONSatlasNode) * atlas->cnodes);
 		if (atlas->nodes == NULL)
 			return 0;
 	}
@@ -693,14 +711,14 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	FONScontext* stash = NULL;
 
 	// Allocate memory for the font stash.
-	stash = (FONScontext*)malloc(sizeof(FONScontext));
+	stash = (FONScontext*)fons__realloc(params, NULL, sizeof(FONScontext));
 	if (stash == NULL) goto error;
 	memset(stash, 0, sizeof(FONScontext));
 
 	stash->params = *params;
 
 	// Allocate scratch buffer.
-	stash->scratch = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	stash->scratch = (unsigned char*)fons__realloc(&stash->params, NULL, FONS_SCRATCH_BUF_SIZE);
 	if (stash->scratch == NULL) goto error;
 
 	// Initialize implementation library
@@ -711,11 +729,11 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 			goto error;
 	}
 
-	stash->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
+	stash->atlas = fons__allocAtlas(&stash->params, stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
 	if (stash->atlas == NULL) goto error;
 
 	// Allocate space for fonts.
-	stash->fonts = (FONSfont**)malloc(sizeof(FONSfont*) * FONS_INIT_FONTS);
+	stash->fonts = (FONSfont**)fons__realloc(&stash->params, NULL, sizeof(FONSfont*) * FONS_INIT_FONTS);
 	if (stash->fonts == NULL) goto error;
 	memset(stash->fonts, 0, sizeof(FONSfont*) * FONS_INIT_FONTS);
 	stash->cfonts = FONS_INIT_FONTS;
@@ -724,7 +742,7 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	// Create texture for the cache.
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
-	stash->texData = (unsigned char*)malloc(stash->params.width * stash->params.height);
+	stash->texData = (unsigned char*)fons__realloc(&stash->params, NULL, stash->params.width * stash->params.height);
 	if (stash->texData == NULL) goto error;
 	memset(stash->texData, 0, stash->params.width * stash->params.height);
 
@@ -814,12 +832,16 @@ void fonsClearState(FONScontext* stash)
 	state->align = FONS_ALIGN_LEFT | FONS_ALIGN_BASELINE;
 }
 
-static void fons__freeFont(FONSfont* font)
+// freeData value for font data loaded by fonsAddFont, which is allocated with the stash allocator.
+#define FONS__FREE_DATA_STASH 2
+
+static void fons__freeFont(FONScontext* stash, FONSfont* font)
 {
 	if (font == NULL) return;
-	if (font->glyphs) free(font->glyphs);
-	if (font->freeData && font->data) free(font->data);
-	free(font);
+	if (font->glyphs) fons__realloc(&stash->params, font->glyphs, 0);
+	if (font->freeData == FONS__FREE_DATA_STASH && font->data) fons__realloc(&stash->params, font->data, 0);
+	else if (font->freeData && font->data) free(font->data);
+	fons__realloc(&stash->params, font, 0);
 }
 
 static int fons__allocFont(FONScontext* stash)
@@ -827,15 +849,15 @@ static int fons__allocFont(FONScontext* stash)
 	FONSfont* font = NULL;
 	if (stash->nfonts+1 > stash->cfonts) {
 		stash->cfonts = stash->cfonts == 0 ? 8 : stash->cfonts * 2;
-		stash->fonts = (FONSfont**)realloc(stash->fonts, sizeof(FONSfont*) * stash->cfonts);
+		stash->fonts = (FONSfont**)fons__realloc(&stash->params, stash->fonts, sizeof(FONSfont*) * stash->cfonts);
 		if (stash->fonts == NULL)
 			return -1;
 	}
-	font = (FONSfont*)malloc(sizeof(FONSfont));
+	font = (FONSfont*)fons__realloc(&stash->params, NULL, sizeof(FONSfont));
 	if (font == NULL) goto error;
 	memset(font, 0, sizeof(FONSfont));
 
-	font->glyphs = (FONSglyph*)malloc(sizeof(FONSglyph) * FONS_INIT_GLYPHS);
+	font->glyphs = (FONSglyph*)fons__realloc(&stash->params, NULL, sizeof(FONSglyph) * FONS_INIT_GLYPHS);
 	if (font->glyphs == NULL) goto error;
 	font->cglyphs = FONS_INIT_GLYPHS;
 	font->nglyphs = 0;
@@ -844,7 +866,7 @@ static int fons__allocFont(FONScontext* stash)
 	return stash->nfonts-1;
 
 error:
-	fons__freeFont(font);
+	fons__freeFont(stash, font);
 
 	return FONS_INVALID;
 }
@@ -861,16 +883,16 @@ int fonsAddFont(FONScontext* stash, const char* name, const char* path)
 	fseek(fp,0,SEEK_END);
 	dataSize = (int)ftell(fp);
 	fseek(fp,0,SEEK_SET);
-	data = (unsigned char*)malloc(dataSize);
+	data = (unsigned char*)fons__realloc(&stash->params, NULL, dataSize);
 	if (data == NULL) goto error;
 	fread(data, 1, dataSize, fp);
 	fclose(fp);
 	fp = 0;
 
-	return fonsAddFontMem(stash, name, data, dataSize, 1);
+	return fonsAddFontMem(stash, name, data, dataSize, FONS__FREE_DATA_STASH);
 
 error:
-	if (data) free(data);
+	if (data) fons__realloc(&stash->params, data, 0);
 	if (fp) fclose(fp);
 	return FONS_INVALID;
 }
@@ -913,7 +935,7 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	return idx;
 
 error:
-	fons__freeFont(font);
+	fons__freeFont(stash, font);
 	stash->nfonts--;
 	return FONS_INVALID;
 }
@@ -929,11 +951,11 @@ int fonsGetFontByName(FONScontext* s, const char* name)
 }
 
 
-static FONSglyph* fons__allocGlyph(FONSfont* font)
+static FONSglyph* fons__allocGlyph(FONScontext* stash, FONSfont* font)
 {
 	if (font->nglyphs+1 > font->cglyphs) {
 		font->cglyphs = font->cglyphs == 0 ? 8 : font->cglyphs * 2;
-		font->glyphs = (FONSglyph*)realloc(font->glyphs, sizeof(FONSglyph) * font->cglyphs);
+		font->glyphs = (FONSglyph*)fons__realloc(&stash->params, font->glyphs, sizeof(FONSglyph) * font->cglyphs);
 		if (font->glyphs == NULL) return NULL;
 	}
 	font->nglyphs++;
@@ -1051,7 +1073,7 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	if (added == 0) return NULL;
 
 	// Init glyph.
-	glyph = fons__allocGlyph(font);
+	glyph = fons__allocGlyph(stash, font);
 	glyph->codepoint = codepoint;
 	glyph->size = isize;
 	glyph->blur = iblur;
@@ -1558,13 +1580,13 @@ void fonsDeleteInternal(FONScontext* stash)
 		stash->params.renderDelete(stash->params.userPtr);
 
 	for (i = 0; i < stash->nfonts; ++i)
-		fons__freeFont(stash->fonts[i]);
+		fons__freeFont(stash, stash->fonts[i]);
 
 	if (stash->atlas) fons__deleteAtlas(stash->atlas);
-	if (stash->fonts) free(stash->fonts);
-	if (stash->texData) free(stash->texData);
-	if (stash->scratch) free(stash->scratch);
-	free(stash);
+	if (stash->fonts) fons__realloc(&stash->params, stash->fonts, 0);
+	if (stash->texData) fons__realloc(&stash->params, stash->texData, 0);
+	if (stash->scratch) fons__realloc(&stash->params, stash->scratch, 0);
+	fons__realloc(&stash->params, stash, 0);
 }
 
 void fonsSetErrorCallback(FONScontext* stash, void (*callback)(void* uptr, int error, int val), void* uptr)
@@ -1602,7 +1624,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 			return 0;
 	}
 	// Copy old texture data over.
-	data = (unsigned char*)malloc(width * height);
+	data = (unsigned char*)fons__realloc(&stash->params, NULL, width * height);
 	if (data == NULL)
 		return 0;
 	for (i = 0; i < stash->params.height; i++) {
@@ -1615,7 +1637,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 	if (height > stash->params.height)
 		memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
 
-	free(stash->texData);
+	fons__realloc(&stash->params, stash->texData, 0);
 	stash->texData = data;
 
 	// Increase atlas size
@@ -1655,7 +1677,7 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	fons__atlasReset(stash->atlas, width, height);
 
 	// Clear texture data.
-	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
+	stash->texData = (unsigned char*)fons__realloc(&stash->params, stash->texData, width * height);
 	if (stash->texData == NULL) return 0;
 	memset(stash->texData, 0, width * height);
 
@@ -21,6 +21,21 @@
 #include "nanovg.h"
 #define FONTSTASH_IMPLEMENTATION
 #include "fontstash.h"
+
+#ifdef _MSC_VER
+#define NVG_THREAD_LOCAL __declspec(thread)
+#else
+#define NVG_THREAD_LOCAL __thread
+#endif
+
+static NVG_THREAD_LOCAL const NVGallocator* nvg__threadAllocator = NULL;
+
+// Images are decoded inside nvgCreateImage and nvgCreateImageMem, which set this to the context's allocator.
+static NVG_THREAD_LOCAL const NVGallocator* nvg__imageAllocator = NULL;
+
+#define STBI_MALLOC(sz) nvgRealloc(nvg__imageAllocator, NULL, sz, NVG_MEMORY_IMAGES)
+#define STBI_REALLOC(p,sz) nvgRealloc(nvg__imageAllocator, p, sz, NVG_MEMORY_IMAGES)
+#define STBI_FREE(p) nvgRealloc(nvg__imageAllocator, p, 0, NVG_MEMORY_IMAGES)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -106,6 +121,7 @@ typedef struct NVGpathCache NVGpathCache;
 
 struct NVGcontext {
 	NVGparams params;
+	NVGallocator allocator;
 	float* commands;
 	int ccommands;
 	int ncommands;
@@ -156,39 +172,65 @@ static float nvg__normalize(float *x, float* y)
 }
 
 
-static void nvg__deletePathCache(NVGpathCache* c)
+void nvgSetAllocator(const NVGallocator* allocator)
+{
+	nvg__threadAllocator = allocator;
+}
+
+const NVGallocator* nvgGetAllocator(void)
+{
+	return nvg__threadAllocator;
+}
+
+void* nvgRealloc(const NVGallocator* allocator, void* ptr, size_t size, int category)
+{
+	if (allocator != NULL && allocator->reallocate != NULL)
+		return allocator->reallocate(allocator->userPtr, ptr, size, category);
+	if (size == 0) {
+		free(ptr);
+		return NULL;
+	}
+	return realloc(ptr, size);
+}
+
+static void* nvg__fontRealloc(void* uptr, void* ptr, size_t size)
+{
+	return nvgRealloc((const NVGallocator*)uptr, ptr, size, NVG_MEMORY_FONTS);
+}
+
+static void nvg__deletePathCache(const NVGallocator* allocator, NVGpathCache* c)
 {
 	if (c == NULL) return;
-	if (c->points != NULL) free(c->points);
-	if (c->paths != NULL) free(c->paths);
-	if (c->verts != NULL) free(c->verts);
-	free(c);
+	if (c->points != NULL) nvgRealloc(allocator, c->points, 0, NVG_MEMORY_GEOMETRY);
+	if (c->paths != NULL) nvgRealloc(allocator, c->paths, 0, NVG_MEMORY_GEOMETRY);
+	if (c->verts != NULL) nvgRealloc(allocator, c->verts, 0, NVG_MEMORY_GEOMETRY);
+	nvgRealloc(allocator, c, 0, NVG_MEMORY_CONTEXT);
 }
 
-static NVGpathCache* nvg__allocPathCache(void)
+static NVGpathCache* nvg__allocPathCache(const NVGallocator* allocator)
 {
-	NVGpathCache* c = (NVGpathCache*)malloc(sizeof(NVGpathCache));
+	NVGpathCache* c = (NVGpathCache*)nvgRealloc(allocator, NULL, sizeof(NVGpathCache), NVG_MEMORY_CONTEXT);
 	if (c == NULL) goto error;
 	memset(c, 0, sizeof(NVGpathCache));
 
-	c->points = (NVGpoint*)malloc(sizeof(NVGpoint)*NVG_INIT_POINTS_SIZE);
+	c->points = (NVGpoint*)nvgRealloc(allocator, NULL, sizeof(NVGpoint)*NVG_INIT_POINTS_SIZE, NVG_MEMORY_GEOMETRY);
 	if (!c->points) goto error;
 	c->npoints = 0;
 	c->cpoints = NVG_INIT_POINTS_SIZE;
 
-	c->paths = (NVGpath*)malloc(sizeof(NVGpath)*NVG_INIT_PATHS_SIZE);
+	c->paths = (NVGpath*)nvgRealloc(allocator, NULL, sizeof(NVGpath)*NVG_INIT_PATHS_SIZE, NVG_MEMORY_GEOMETRY);
 	if (!c->paths) goto error;
 	c->npaths = 0;
 	c->cpaths = NVG_INIT_PATHS_SIZE;
 
-	c->verts = (NVGvertex*)malloc(sizeof(NVGvertex)*NVG_INIT_VERTS_SIZE);
+	c->verts = (NVGvertex*)nvgRealloc(allocator, NULL, sizeof(NVGvertex)*NVG_INIT_VERTS_SIZE, NVG_MEMORY_GEOMETRY);
 	if (!c->verts) goto error;
 	c->nverts = 0;
 	c->cverts = NVG_INIT_VERTS_SIZE;
 
 	return c;
 error:
-	nvg__deletePathCache(c);
+	nvg__deletePathCache(allocator, c);
 	return NULL;
 }
 
@@ -203,21 +245,23 @@ static void nvg__setDevicePixelRatio(NVGcontext* ctx, float ratio)
 NVGcontext* nvgCreateInternal(NVGparams* params)
 {
 	FONSparams fontParams;
-	NVGcontext* ctx = (NVGcontext*)malloc(sizeof(NVGcontext));
+	NVGcontext* ctx = (NVGcontext*)nvgRealloc(nvg__threadAllocator, NULL, sizeof(NVGcontext), NVG_MEMORY_CONTEXT);
 	int i;
 	if (ctx == NULL) goto error;
 	memset(ctx, 0, sizeof(NVGcontext));
+	if (nvg__threadAllocator != NULL)
+		ctx->allocator = *nvg__threadAllocator;
 
 	ctx->params = *params;
 	for (i = 0; i < NVG_MAX_FONTIMAGES; i++)
 		ctx->fontImages[i] = 0;
 
-	ctx->commands = (float*)malloc(sizeof(float)*NVG_INIT_COMMANDS_SIZE);
+	ctx->commands = (float*)nvgRealloc(&ctx->allocator, NULL, sizeof(float)*NVG_INIT_COMMANDS_SIZE, NVG_MEMORY_COMMANDS);
 	if (!ctx->commands) goto error;
 	ctx->ncommands = 0;
 	ctx->ccommands = NVG_INIT_COMMANDS_SIZE;
 
-	ctx->cache = nvg__allocPathCache();
+	ctx->cache = nvg__allocPathCache(&ctx->allocator);
 	if (ctx->cache == NULL) goto error;
 
 	nvgSave(ctx);
@@ -237,6 +281,8 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	fontParams.renderDraw = NULL;
 	fontParams.renderDelete = NULL;
 	fontParams.userPtr = NULL;
+	fontParams.memRealloc = nvg__fontRealloc;
+	fontParams.memUserPtr = &ctx->allocator;
 	ctx->fs = fonsCreateInternal(&fontParams);
 	if (ctx->fs == NULL) goto error;
 
@@ -259,10 +305,12 @@ NVGparams* nvgInternalParams(NVGcontext* ctx)
 
 void nvgDeleteInternal(NVGcontext* ctx)
 {
+	NVGallocator allocator;
 	int i;
 	if (ctx == NULL) return;
-	if (ctx->commands != NULL) free(ctx->commands);
-	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
+	allocator = ctx->allocator;
+	if (ctx->commands != NULL) nvgRealloc(&allocator, ctx->commands, 0, NVG_MEMORY_COMMANDS);
+	if (ctx->cache != NULL) nvg__deletePathCache(&allocator, ctx->cache);
 
 	if (ctx->fs)
 		fonsDeleteInternal(ctx->fs);
@@ -277,7 +325,7 @@ void nvgDeleteInternal(NVGcontext* ctx)
 	if (ctx->params.renderDelete != NULL)
 		ctx->params.renderDelete(ctx->params.userPtr);
 
-	free(ctx);
+	nvgRealloc(&allocator, ctx, 0, NVG_MEMORY_CONTEXT);
 }
 
 void nvgBeginFrame(NVGcontext* ctx, int windowWidth, int windowHeight, float devicePixelRatio)
@@ -709,26 +757,33 @@ int nvgCreateImage(NVGcontext* ctx, const char* filename, int imageFlags)
 	unsigned char* img;
 	stbi_set_unpremultiply_on_load(1);
 	stbi_convert_iphone_png_to_rgb(1);
+	nvg__imageAllocator = &ctx->allocator;
 	img = stbi_load(filename, &w, &h, &n, 4);
 	if (img == NULL) {
 //		printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
+		nvg__imageAllocator = NULL;
 		return 0;
 	}
 	image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
 	stbi_image_free(img);
+	nvg__imageAllocator = NULL;
 	return image;
 }
 
 int nvgCreateImageMem(NVGcontext* ctx, int imageFlags, unsigned char* data, int ndata)
 {
 	int w, h, n, image;
-	unsigned char* img = stbi_load_from_memory(data, ndata, &w, &h, &n, 4);
+	unsigned char* img;
+	nvg__imageAllocator = &ctx->allocator;
+	img = stbi_load_from_memory(data, ndata, &w, &h, &n, 4);
 	if (img == NULL) {
 //		printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
+		nvg__imageAllocator = NULL;
 		return 0;
 	}
 	image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
 	stbi_image_free(img);
+	nvg__imageAllocator = NULL;
 	return image;
 }
 
@@ -968,7 +1023,7 @@ static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
 	if (ctx->ncommands+nvals > ctx->ccommands) {
 		float* commands;
 		int ccommands = ctx->ncommands+nvals + ctx->ccommands/2;
-		commands = (float*)realloc(ctx->commands, sizeof(float)*ccommands);
+		commands = (float*)nvgRealloc(&ctx->allocator, ctx->commands, sizeof(float)*ccommands, NVG_MEMORY_COMMANDS);
 		if (commands == NULL) return;
 		ctx->commands = commands;
 		ctx->ccommands = ccommands;
@@ -1034,7 +1089,7 @@ static void nvg__addPath(NVGcontext* ctx)
 	if (ctx->cache->npaths+1 > ctx->cache->cpaths) {
 		NVGpath* paths;
 		int cpaths = ctx->cache->npaths+1 + ctx->cache->cpaths/2;
-		paths = (NVGpath*)realloc(ctx->cache->paths, sizeof(NVGpath)*cpaths);
+		paths = (NVGpath*)nvgRealloc(&ctx->allocator, ctx->cache->paths, sizeof(NVGpath)*cpaths, NVG_MEMORY_GEOMETRY);
 		if (paths == NULL) return;
 		ctx->cache->paths = paths;
 		ctx->cache->cpaths = cpaths;
@@ -1071,7 +1126,7 @@ static void nvg__addPoint(NVGcontext* ctx, float x, float y, int flags)
 	if (ctx->cache->npoints+1 > ctx->cache->cpoints) {
 		NVGpoint* points;
 		int cpoints = ctx->cache->npoints+1 + ctx->cache->cpoints/2;
-		points = (NVGpoint*)realloc(ctx->cache->points, sizeof(NVGpoint)*cpoints);
+		points = (NVGpoint*)nvgRealloc(&ctx->allocator, ctx->cache->points, sizeof(NVGpoint)*cpoints, NVG_MEMORY_GEOMETRY);
 		if (points == NULL) return;
 		ctx->cache->points = points;
 		ctx->cache->cpoints = cpoints;
@@ -1113,7 +1168,7 @@ static NVGvertex* nvg__allocTempVerts(NVGcontext* ctx, int nverts)
 	if (nverts > ctx->cache->cverts) {
 		NVGvertex* verts;
 		int cverts = (nverts + 0xff) & ~0xff; // Round up to prevent allocations when things change just slightly.
-		verts = (NVGvertex*)realloc(ctx->cache->verts, sizeof(NVGvertex)*cverts);
+		verts = (NVGvertex*)nvgRealloc(&ctx->allocator, ctx->cache->verts, sizeof(NVGvertex)*cverts, NVG_MEMORY_GEOMETRY);
 		if (verts == NULL) return NULL;
 		ctx->cache->verts = verts;
 		ctx->cache->cverts = cverts;
@@ -19,6 +19,8 @@
 #ifndef NANOVG_H
 #define NANOVG_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -547,6 +549,42 @@ void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* l
 // Words longer than the max width are slit at nearest character (i.e. no hyphenation).
 int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows);
 
+//
+// Memory
+//
+// By default NanoVG, fontstash and the render back-ends allocate with malloc, realloc and free.
+// An allocator can be set for the calling thread with nvgSetAllocator. Contexts created on that
+// thread afterwards, including the back-end context created by nvgCreateGL*(), keep a copy of it
+// and use it for all their allocations.
+
+enum NVGmemoryCategory {
+	NVG_MEMORY_CONTEXT,		// Context and path cache structures.
+	NVG_MEMORY_COMMANDS,	// Recorded path commands.
+	NVG_MEMORY_GEOMETRY,	// Flattened points, paths and vertices.
+	NVG_MEMORY_FONTS,		// Font data, glyphs, atlas and texture data.
+	NVG_MEMORY_IMAGES,		// Decoded images.
+	NVG_MEMORY_BACKEND,		// Render back-end calls, paths, vertices, uniforms and textures.
+	NVG_MEMORY_COUNT
+};
+
+struct NVGallocator {
+	// Allocates if ptr is NULL, frees if size is 0 (and returns NULL), otherwise reallocates.
+	void* (*reallocate)(void* userPtr, void* ptr, size_t size, int category);
+	void* userPtr;
+};
+typedef struct NVGallocator NVGallocator;
+
+// Sets the allocator for contexts created on the calling thread from now on. The allocator must
+// stay valid while it is set. Pass NULL to use the C runtime.
+void nvgSetAllocator(const NVGallocator* allocator);
+
+// Returns the allocator set on the calling thread, or NULL.
+const NVGallocator* nvgGetAllocator(void);
+
+// Allocates, reallocates or frees with the allocator, or with the C runtime if allocator is NULL
+// or has no reallocate function.
+void* nvgRealloc(const NVGallocator* allocator, void* ptr, size_t size, int category);
+
 //
 // Internal Render API
 //
@@ -226,6 +226,7 @@ struct GLNVGcontext {
 #endif
 	int fragSize;
 	int flags;
+	NVGallocator allocator;
 
 	// Per frame buffers
 	GLNVGcall* calls;
@@ -324,7 +325,7 @@ static GLNVGtexture* glnvg__allocTexture(GLNVGcontext* gl)
 		if (gl->ntextures+1 > gl->ctextures) {
 			GLNVGtexture* textures;
 			int ctextures = glnvg__maxi(gl->ntextures+1, 4) +  gl->ctextures/2; // 1.5x Overallocate
-			textures = (GLNVGtexture*)realloc(gl->textures, sizeof(GLNVGtexture)*ctextures);
+			textures = (GLNVGtexture*)nvgRealloc(&gl->allocator, gl->textures, sizeof(GLNVGtexture)*ctextures, NVG_MEMORY_BACKEND);
 			if (textures == NULL) return NULL;
 			gl->textures = textures;
 			gl->ctextures = ctextures;
@@ -1166,7 +1167,7 @@ static GLNVGcall* glnvg__allocCall(GLNVGcontext* gl)
 	if (gl->ncalls+1 > gl->ccalls) {
 		GLNVGcall* calls;
 		int ccalls = glnvg__maxi(gl->ncalls+1, 128) + gl->ccalls/2; // 1.5x Overallocate
-		calls = (GLNVGcall*)realloc(gl->calls, sizeof(GLNVGcall) * ccalls);
+		calls = (GLNVGcall*)nvgRealloc(&gl->allocator, gl->calls, sizeof(GLNVGcall) * ccalls, NVG_MEMORY_BACKEND);
 		if (calls == NULL) return NULL;
 		gl->calls = calls;
 		gl->ccalls = ccalls;
@@ -1182,7 +1183,7 @@ static int glnvg__allocPaths(GLNVGcontext* gl, int n)
 	if (gl->npaths+n > gl->cpaths) {
 		GLNVGpath* paths;
 		int cpaths = glnvg__maxi(gl->npaths + n, 128) + gl->cpaths/2; // 1.5x Overallocate
-		paths = (GLNVGpath*)realloc(gl->paths, sizeof(GLNVGpath) * cpaths);
+		paths = (GLNVGpath*)nvgRealloc(&gl->allocator, gl->paths, sizeof(GLNVGpath) * cpaths, NVG_MEMORY_BACKEND);
 		if (paths == NULL) return -1;
 		gl->paths = paths;
 		gl->cpaths = cpaths;
@@ -1198,7 +1199,7 @@ static int glnvg__allocVerts(GLNVGcontext* gl, int n)
 	if (gl->nverts+n > gl->cverts) {
 		NVGvertex* verts;
 		int cverts = glnvg__maxi(gl->nverts + n, 4096) + gl->cverts/2; // 1.5x Overallocate
-		verts = (NVGvertex*)realloc(gl->verts, sizeof(NVGvertex) * cverts);
+		verts = (NVGvertex*)nvgRealloc(&gl->allocator, gl->verts, sizeof(NVGvertex) * cverts, NVG_MEMORY_BACKEND);
 		if (verts == NULL) return -1;
 		gl->verts = verts;
 		gl->cverts = cverts;
@@ -1214,7 +1215,7 @@ static int glnvg__allocFragUniforms(GLNVGcontext* gl, int n)
 	if (gl->nuniforms+n > gl->cuniforms) {
 		unsigned char* uniforms;
 		int cuniforms = glnvg__maxi(gl->nuniforms+n, 128) + gl->cuniforms/2; // 1.5x Overallocate
-		uniforms = (unsigned char*)realloc(gl->uniforms, structSize * cuniforms);
+		uniforms = (unsigned char*)nvgRealloc(&gl->allocator, gl->uniforms, structSize * cuniforms, NVG_MEMORY_BACKEND);
 		if (uniforms == NULL) return -1;
 		gl->uniforms = uniforms;
 		gl->cuniforms = cuniforms;
@@ -1410,6 +1411,7 @@ error:
 static void glnvg__renderDelete(void* uptr)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	NVGallocator allocator;
 	int i;
 	if (gl == NULL) return;
 
@@ -1430,14 +1432,15 @@ static void glnvg__renderDelete(void* uptr)
 		if (gl->textures[i].tex != 0 && (gl->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
 			glDeleteTextures(1, &gl->textures[i].tex);
 	}
-	free(gl->textures);
+	allocator = gl->allocator;
+	nvgRealloc(&allocator, gl->textures, 0, NVG_MEMORY_BACKEND);
 
-	free(gl->paths);
-	free(gl->verts);
-	free(gl->uniforms);
-	free(gl->calls);
+	nvgRealloc(&allocator, gl->paths, 0, NVG_MEMORY_BACKEND);
+	nvgRealloc(&allocator, gl->verts, 0, NVG_MEMORY_BACKEND);
+	nvgRealloc(&allocator, gl->uniforms, 0, NVG_MEMORY_BACKEND);
+	nvgRealloc(&allocator, gl->calls, 0, NVG_MEMORY_BACKEND);
 
-	free(gl);
+	nvgRealloc(&allocator, gl, 0, NVG_MEMORY_BACKEND);
 }
 
 
@@ -1453,9 +1456,11 @@ NVGcontext* nvgCreateGLES3(int flags)
 {
 	NVGparams params;
 	NVGcontext* ctx = NULL;
-	GLNVGcontext* gl = (GLNVGcontext*)malloc(sizeof(GLNVGcontext));
+	const NVGallocator* allocator = nvgGetAllocator();
+	GLNVGcontext* gl = (GLNVGcontext*)nvgRealloc(allocator, NULL, sizeof(GLNVGcontext), NVG_MEMORY_BACKEND);
 	if (gl == NULL) goto error;
 	memset(gl, 0, sizeof(GLNVGcontext));
+	if (allocator != NULL) gl->allocator = *allocator;
 
 	memset(&params, 0, sizeof(params));
 	params.renderCreate = glnvg__renderCreate;
@@ -8,6 +8,12 @@ if os.get() == "windows" then
 	os.copyfile("examples/sdl/lib/x64/SDL2.dll", "build/bin_x64/SDL2.dll");
 end
 
+newoption
+{
+	trigger = "tsan",
+	description = "Build with ThreadSanitizer (gcc and clang)"
+}
+
 -----------------------------------------------------------------------------
 
 solution "WidgetZero"
@@ -35,6 +41,13 @@ solution "WidgetZero"
 
 	configuration { "x64" }
 		targetdir "build/bin_x64"
+
+	configuration {}
+
+	if _OPTIONS["tsan"] then
+		buildoptions { "-fsanitize=thread" }
+		linkoptions { "-fsanitize=thread" }
+	end
 	
 -----------------------------------------------------------------------------
 
@@ -99,3 +112,18 @@ project "Example 3 - Custom Renderer"
 	
 	configuration "vs2012"
 		linkoptions { "/SAFESEH:NO" }
+
+-----------------------------------------------------------------------------
+
+project "Example 4 - Threads"
+	kind "ConsoleApp"
+	targetname "example_threads"
+	files { "examples/Threads.cpp" }
+	includedirs { "src", "nanovg" }
+	links { "WidgetZero", "NanoVG" }
+
+	configuration "linux"
+		links { "pthread" }
+
+	configuration "vs2012"
+		linkoptions { "/SAFESEH:NO" }
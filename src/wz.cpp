@@ -24,6 +24,10 @@ SOFTWARE.
 #include "wz.h"
 #pragma hdrstop
 
+#ifdef _MSC_VER
+#include <Windows.h>
+#endif
+
 #define WZ_NOT_IMPLEMENTED { WZ_ASSERT("not implemented" && false); }
 #define WZ_NOT_IMPLEMENTED_RETURN(type) { WZ_ASSERT("not implemented" && false); return type(); }
 
@@ -47,6 +51,7 @@ Size IRenderer::measureGroupBox(GroupBox *) { WZ_NOT_IMPLEMENTED_RETURN(Size) }
 Color IRenderer::getLabelTextColor(Label *) { WZ_NOT_IMPLEMENTED_RETURN(Color) }
 void IRenderer::drawLabel(Label *, Rect) { WZ_NOT_IMPLEMENTED }
 Size IRenderer::measureLabel(Label *) { WZ_NOT_IMPLEMENTED_RETURN(Size) }
+Size IRenderer::measureLabelWrapped(Label *label, int) { return measureLabel(label); }
 void IRenderer::drawList(List *, Rect) { WZ_NOT_IMPLEMENTED }
 Size IRenderer::measureList(List *) { WZ_NOT_IMPLEMENTED_RETURN(Size) }
 void IRenderer::drawMenuBarButton(MenuBarButton *, Rect) { WZ_NOT_IMPLEMENTED }
@@ -80,6 +85,487 @@ Size IRenderer::measureWindow(Window *) { WZ_NOT_IMPLEMENTED_RETURN(Size) }
 int IRenderer::getLineHeight(const char *, float) { WZ_NOT_IMPLEMENTED_RETURN(int) }
 void IRenderer::measureText(const char *, float, const char *, int, int *, int *) { WZ_NOT_IMPLEMENTED }
 LineBreakResult IRenderer::lineBreakText(const char *, float, const char *, int, int) { WZ_NOT_IMPLEMENTED_RETURN(LineBreakResult) }
+size_t IRenderer::getMemoryUsage() const { return 0; }
+
+/*
+================================================================================
+
+ALLOCATION CHECK
+
+================================================================================
+*/
+
+static WZ_THREAD_LOCAL AllocationCheckCallback allocationCheckCallback;
+static WZ_THREAD_LOCAL void *allocationCheckData;
+
+// Set while the callback runs, so allocations it makes aren't reported.
+static WZ_THREAD_LOCAL bool allocationCheckReporting;
+
+AllocationCheck::Scope::Scope(AllocationCheckCallback callback, void *data)
+{
+	active_ = callback != NULL;
+
+	if (active_)
+	{
+		previousCallback_ = allocationCheckCallback;
+		previousData_ = allocationCheckData;
+		allocationCheckCallback = callback;
+		allocationCheckData = data;
+	}
+}
+
+AllocationCheck::Scope::~Scope()
+{
+	if (active_)
+	{
+		allocationCheckCallback = previousCallback_;
+		allocationCheckData = previousData_;
+	}
+}
+
+bool AllocationCheck::isActive()
+{
+	return allocationCheckCallback != NULL;
+}
+
+void AllocationCheck::report(AllocationCategory::Enum category, size_t size, const void *callSite)
+{
+	if (!allocationCheckCallback || allocationCheckReporting)
+		return;
+
+	allocationCheckReporting = true;
+	allocationCheckCallback(category, size, callSite, allocationCheckData);
+	allocationCheckReporting = false;
+}
+
+void AllocationCheck::fail(AllocationCategory::Enum category, size_t size, const void *callSite, void *)
+{
+	static const char *categoryNames[] =
+	{
+		"Widgets",
+		"NanoVGContext",
+		"NanoVGCommands",
+		"NanoVGGeometry",
+		"NanoVGFonts",
+		"NanoVGImages",
+		"NanoVGBackend",
+		"Other"
+	};
+
+	char message[128];
+	sprintf(message, "Unexpected allocation of %u bytes (%s) at %p\n", (unsigned int)size, categoryNames[category], callSite);
+
+#ifdef _MSC_VER
+	OutputDebugString(message);
+#else
+	fputs(message, stdout);
+#endif
+
+	WZ_ASSERT(false);
+}
+
+/*
+================================================================================
+
+POOL
+
+================================================================================
+*/
+
+struct PoolBlock
+{
+	PoolBlock *next;
+};
+
+struct PoolChunk
+{
+	PoolChunk *next;
+};
+
+// Block sizes are rounded up to a multiple of this. Also keeps blocks aligned.
+static const size_t poolGranularity = 16;
+
+// Anything bigger goes straight to the allocator.
+static const size_t poolMaxBlockSize = 1024;
+
+// Blocks are allocated in chunks of this many.
+static const size_t poolBlocksPerChunk = 32;
+
+// Blocks are prefixed with the pool they came from. Padded to keep the block aligned.
+static const size_t poolBlockHeaderSize = 16;
+
+// Chunks are prefixed with the next chunk in their pool. Padded to keep the blocks aligned.
+static const size_t poolChunkHeaderSize = 16;
+
+struct Pool::Arena
+{
+	// NULL means malloc.
+	IAllocator *allocator;
+
+	PoolBlock *freeLists[poolMaxBlockSize / poolGranularity];
+	PoolChunk *chunks;
+
+	// Blocks in use, including large blocks. Not counted for default pools.
+	size_t nBlocks;
+
+	// False for the per-thread default pools, which are never released.
+	bool created;
+
+	// Pool::release has been called, destroy the pool when the last block is freed.
+	bool released;
+
+	// On the thread's pool stack, see Pool::push.
+	bool pushed;
+
+	// The pool below this one on the stack. NULL means the default pool.
+	Pool::Arena *below;
+};
+
+// Each thread has its own default pool, so main windows on different threads don't contend or race.
+static WZ_THREAD_LOCAL Pool::Arena poolDefault;
+
+// The top of the pool stack, see Pool::push. NULL means poolDefault.
+static WZ_THREAD_LOCAL Pool::Arena *poolCurrent;
+
+static void *PoolReallocate(IAllocator *allocator, void *p, size_t size)
+{
+	if (allocator)
+		return allocator->reallocate(p, size, AllocationCategory::Widgets);
+
+	if (size == 0)
+	{
+		::free(p);
+		return NULL;
+	}
+
+	return realloc(p, size);
+}
+
+static void PoolDestroy(Pool::Arena *pool)
+{
+	IAllocator *allocator = pool->allocator;
+	PoolChunk *chunk = pool->chunks;
+
+	while (chunk)
+	{
+		PoolChunk *next = chunk->next;
+		PoolReallocate(allocator, chunk, 0);
+		chunk = next;
+	}
+
+	PoolReallocate(allocator, pool, 0);
+}
+
+void *Pool::allocate(size_t size)
+{
+	if (allocationCheckCallback)
+	{
+		AllocationCheck::report(AllocationCategory::Widgets, size, WZ_RETURN_ADDRESS());
+	}
+
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	Arena *pool = poolCurrent ? poolCurrent : &poolDefault;
+	char *block;
+
+	if (size > poolMaxBlockSize)
+	{
+		block = (char *)PoolReallocate(pool->allocator, NULL, poolBlockHeaderSize + size);
+
+		if (!block)
+			throw std::bad_alloc();
+	}
+	else
+	{
+		const size_t index = (size - 1) / poolGranularity;
+
+		if (!pool->freeLists[index])
+		{
+			// Free list is empty, split a new chunk into blocks.
+			const size_t blockSize = poolBlockHeaderSize + (index + 1) * poolGranularity;
+			char *chunk = (char *)PoolReallocate(pool->allocator, NULL, poolChunkHeaderSize + blockSize * poolBlocksPerChunk);
+
+			if (!chunk)
+				throw std::bad_alloc();
+
+			((PoolChunk *)chunk)->next = pool->chunks;
+			pool->chunks = (PoolChunk *)chunk;
+
+			for (size_t i = 0; i < poolBlocksPerChunk; i++)
+			{
+				PoolBlock *freeBlock = (PoolBlock *)(chunk + poolChunkHeaderSize + i * blockSize);
+				freeBlock->next = pool->freeLists[index];
+				pool->freeLists[index] = freeBlock;
+			}
+		}
+
+		block = (char *)pool->freeLists[index];
+		pool->freeLists[index] = ((PoolBlock *)block)->next;
+	}
+
+	if (pool->created)
+	{
+		pool->nBlocks++;
+	}
+
+	*(Arena **)block = pool;
+	return block + poolBlockHeaderSize;
+}
+
+void Pool::free(void *p, size_t size)
+{
+	if (!p)
+		return;
+
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	char *block = (char *)p - poolBlockHeaderSize;
+	Arena *pool = *(Arena **)block;
+
+	if (size > poolMaxBlockSize)
+	{
+		PoolReallocate(pool->allocator, block, 0);
+	}
+	else
+	{
+		// Default pools are never released, so a block from another thread's default pool can go on this thread's, which is the only one safe to touch.
+		Arena *freeListPool = pool->created ? pool : &poolDefault;
+		const size_t index = (size - 1) / poolGranularity;
+		((PoolBlock *)block)->next = freeListPool->freeLists[index];
+		freeListPool->freeLists[index] = (PoolBlock *)block;
+	}
+
+	if (pool->created)
+	{
+		WZ_ASSERT(pool->nBlocks > 0);
+		pool->nBlocks--;
+
+		if (pool->released && pool->nBlocks == 0)
+		{
+			PoolDestroy(pool);
+		}
+	}
+}
+
+Pool::Arena *Pool::create(IAllocator *allocator)
+{
+	Arena *pool = (Arena *)PoolReallocate(allocator, NULL, sizeof(Arena));
+
+	if (!pool)
+		throw std::bad_alloc();
+
+	memset(pool, 0, sizeof(Arena));
+	pool->allocator = allocator;
+	pool->created = true;
+	return pool;
+}
+
+void Pool::release(Arena *pool)
+{
+	WZ_ASSERT(pool && pool->created && !pool->released);
+	WZ_ASSERT(!pool->pushed);
+	pool->released = true;
+
+	if (pool->nBlocks == 0)
+	{
+		PoolDestroy(pool);
+	}
+}
+
+void Pool::push(Arena *pool)
+{
+	WZ_ASSERT(pool && pool->created && !pool->pushed);
+	pool->below = poolCurrent;
+	pool->pushed = true;
+	poolCurrent = pool;
+}
+
+void Pool::remove(Arena *pool)
+{
+	WZ_ASSERT(pool && pool->pushed);
+
+	// Find the link that points at pool and make it skip over it.
+	Arena **link = &poolCurrent;
+
+	while (*link != pool)
+	{
+		WZ_ASSERT(*link);
+		link = &(*link)->below;
+	}
+
+	*link = pool->below;
+	pool->below = NULL;
+	pool->pushed = false;
+}
+
+Pool::Arena *Pool::getCurrent()
+{
+	return poolCurrent;
+}
+
+/*
+================================================================================
+
+TRACKING ALLOCATOR
+
+================================================================================
+*/
+
+// Prefixed to each block. Padded to keep the block aligned.
+struct TrackingAllocatorHeader
+{
+	size_t size;
+	int category;
+};
+
+static const size_t trackingAllocatorHeaderSize = 16;
+
+static void AddAllocation(AllocationStats *stats, size_t size)
+{
+	stats->bytes += size;
+	stats->peakBytes = WZ_MAX(stats->peakBytes, stats->bytes);
+	stats->nAllocations++;
+	stats->nFrameAllocations++;
+}
+
+void *TrackingAllocator::reallocate(void *ptr, size_t size, AllocationCategory::Enum category)
+{
+	WZ_ASSERT(category >= 0 && category < AllocationCategory::NumCategories);
+	char *block = NULL;
+	TrackingAllocatorHeader oldHeader;
+
+	if (ptr)
+	{
+		block = (char *)ptr - trackingAllocatorHeaderSize;
+		oldHeader = *(TrackingAllocatorHeader *)block;
+	}
+
+	if (size == 0)
+	{
+		if (block)
+		{
+			stats_[oldHeader.category].bytes -= oldHeader.size;
+			total_.bytes -= oldHeader.size;
+			::free(block);
+		}
+
+		return NULL;
+	}
+
+	char *newBlock = (char *)realloc(block, trackingAllocatorHeaderSize + size);
+
+	// The old block is still valid.
+	if (!newBlock)
+		return NULL;
+
+	if (block)
+	{
+		stats_[oldHeader.category].bytes -= oldHeader.size;
+		total_.bytes -= oldHeader.size;
+	}
+
+	TrackingAllocatorHeader *header = (TrackingAllocatorHeader *)newBlock;
+	header->size = size;
+	header->category = category;
+	AddAllocation(&stats_[category], size);
+	AddAllocation(&total_, size);
+	return newBlock + trackingAllocatorHeaderSize;
+}
+
+void TrackingAllocator::beginFrame()
+{
+	for (int i = 0; i < AllocationCategory::NumCategories; i++)
+	{
+		stats_[i].nLastFrameAllocations = stats_[i].nFrameAllocations;
+		stats_[i].nFrameAllocations = 0;
+	}
+
+	total_.nLastFrameAllocations = total_.nFrameAllocations;
+	total_.nFrameAllocations = 0;
+}
+
+const AllocationStats &TrackingAllocator::getStats(AllocationCategory::Enum category) const
+{
+	WZ_ASSERT(category >= 0 && category < AllocationCategory::NumCategories);
+	return stats_[category];
+}
+
+const AllocationStats &TrackingAllocator::getTotalStats() const
+{
+	return total_;
+}
+
+/*
+================================================================================
+
+FONT FACES
+
+================================================================================
+*/
+
+// Shared by all main windows. Interned strings are never modified or freed, so only the table needs guarding.
+static std::vector<char *> fontFaces;
+static volatile long fontFacesLock;
+
+// Interning only happens when a font face is set, so a spin lock is enough.
+class FontFacesLock
+{
+public:
+	FontFacesLock()
+	{
+		while (WZ_ATOMIC_EXCHANGE(&fontFacesLock, 1) != 0) {}
+	}
+
+	~FontFacesLock()
+	{
+		WZ_ATOMIC_EXCHANGE(&fontFacesLock, 0);
+	}
+};
+
+const char *FontFaces::intern(const char *fontFace)
+{
+	// Most widgets use the renderer's default font.
+	if (!fontFace || !fontFace[0])
+		return "";
+
+	FontFacesLock lock;
+
+	// There are only ever a handful of font faces, so a linear search is fine.
+	for (size_t i = 0; i < fontFaces.size(); i++)
+	{
+		if (strcmp(fontFaces[i], fontFace) == 0)
+			return fontFaces[i];
+	}
+
+	const size_t length = strlen(fontFace);
+	char *copy = (char *)malloc(length + 1);
+
+	if (!copy)
+		throw std::bad_alloc();
+
+	memcpy(copy, fontFace, length + 1);
+	fontFaces.push_back(copy);
+	return copy;
+}
+
+size_t FontFaces::getMemoryUsage()
+{
+	FontFacesLock lock;
+	size_t size = fontFaces.capacity() * sizeof(char *);
+
+	for (size_t i = 0; i < fontFaces.size(); i++)
+	{
+		size += strlen(fontFaces[i]) + 1;
+	}
+
+	return size;
+}
 
 /*
 SDL_IntersectRect
@@ -144,3 +630,61 @@ bool Rect::intersect(const Rect A, const Rect B, Rect *result)
 }
 
 } // namespace wz
+
+#ifdef WZ_CHECK_ALLOCATIONS
+// Replace the global operator new and delete, so AllocationCheck sees standard library allocations too.
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define WZ_THROW_BAD_ALLOC
+#define WZ_NO_THROW noexcept
+#elif defined(_MSC_VER)
+// MSVC 2013 and earlier don't support noexcept, and warn about (and ignore) dynamic exception specifications other than throw().
+#define WZ_THROW_BAD_ALLOC
+#define WZ_NO_THROW throw()
+#else
+#define WZ_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define WZ_NO_THROW throw()
+#endif
+
+static void *CheckedAllocate(size_t size, const void *callSite)
+{
+	wz::AllocationCheck::report(wz::AllocationCategory::Other, size, callSite);
+	void *p = malloc(size ? size : 1);
+
+	if (!p)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void *operator new(size_t size) WZ_THROW_BAD_ALLOC
+{
+	return CheckedAllocate(size, WZ_RETURN_ADDRESS());
+}
+
+void *operator new[](size_t size) WZ_THROW_BAD_ALLOC
+{
+	return CheckedAllocate(size, WZ_RETURN_ADDRESS());
+}
+
+void operator delete(void *p) WZ_NO_THROW
+{
+	free(p);
+}
+
+void operator delete[](void *p) WZ_NO_THROW
+{
+	free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, size_t) WZ_NO_THROW
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) WZ_NO_THROW
+{
+	free(p);
+}
+#endif
+#endif
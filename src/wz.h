@@ -24,6 +24,7 @@ SOFTWARE.
 #pragma once
 
 #include <stdint.h>
+#include <new>
 #include <vector>
 #include <string>
 
@@ -47,6 +48,24 @@ SOFTWARE.
 
 #define WZCPP_CALL_OBJECT_METHOD(object, method) ((object)->*(method)) 
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#define WZ_THREAD_LOCAL __declspec(thread)
+#define WZ_ATOMIC_EXCHANGE(target, value) _InterlockedExchange((target), (value))
+#define WZ_ATOMIC_COMPARE_EXCHANGE(target, expected, desired) _InterlockedCompareExchange((target), (desired), (expected))
+// Plain volatile accesses are only acquire/release with /volatile:ms, which isn't the default on ARM. Interlocked operations are full barriers on every target.
+#define WZ_ATOMIC_LOAD(source) _InterlockedOr((source), 0)
+#define WZ_ATOMIC_STORE(target, value) ((void)_InterlockedExchange((target), (value)))
+#define WZ_RETURN_ADDRESS() _ReturnAddress()
+#else
+#define WZ_THREAD_LOCAL __thread
+#define WZ_ATOMIC_EXCHANGE(target, value) __atomic_exchange_n((target), (value), __ATOMIC_SEQ_CST)
+#define WZ_ATOMIC_COMPARE_EXCHANGE(target, expected, desired) __sync_val_compare_and_swap((target), (expected), (desired))
+#define WZ_ATOMIC_LOAD(source) __atomic_load_n((source), __ATOMIC_ACQUIRE)
+#define WZ_ATOMIC_STORE(target, value) __atomic_store_n((target), (value), __ATOMIC_RELEASE)
+#define WZ_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
 #define WZ_MAX_WINDOWS 256
 
 namespace wz {
@@ -327,11 +346,203 @@ struct Key
 
 #define WZ_KEY_MOD_OFF(key) ((key) & ~(Key::ShiftBit | Key::ControlBit))
 
+struct AllocationCategory
+{
+	enum Enum
+	{
+		// Widget and event handler objects, see Pool.
+		Widgets,
+
+		// The NanoVG categories are in the same order as NVGmemoryCategory.
+		NanoVGContext,
+		NanoVGCommands,
+		NanoVGGeometry,
+		NanoVGFonts,
+		NanoVGImages,
+		NanoVGBackend,
+
+		// Global operator new, e.g. std::vector and std::string growth. Only seen by AllocationCheck.
+		Other,
+
+		NumCategories
+	};
+};
+
+// Heap memory used by WidgetZero and NanoVG can be routed through an allocator. See Pool::create, MainWindow and NVGRenderer.
+class IAllocator
+{
+public:
+	virtual ~IAllocator() {}
+
+	// Same as realloc: ptr can be NULL, a size of 0 frees ptr and returns NULL. Returns NULL if out of memory. ptr is always freed or resized with the category it was allocated with.
+	virtual void *reallocate(void *ptr, size_t size, AllocationCategory::Enum category) = 0;
+
+	// Called by MainWindow::draw.
+	virtual void beginFrame() {}
+};
+
+struct AllocationStats
+{
+	AllocationStats() : bytes(0), peakBytes(0), nAllocations(0), nFrameAllocations(0), nLastFrameAllocations(0) {}
+
+	size_t bytes;
+
+	// The high-water mark of bytes.
+	size_t peakBytes;
+
+	// Calls that allocated or resized a block.
+	size_t nAllocations;
+
+	// nAllocations since the current frame began.
+	size_t nFrameAllocations;
+
+	// nAllocations during the previous frame.
+	size_t nLastFrameAllocations;
+};
+
+// Allocates from the heap and counts the memory used by each category. Not thread safe, use one per thread.
+class TrackingAllocator : public IAllocator
+{
+public:
+	virtual void *reallocate(void *ptr, size_t size, AllocationCategory::Enum category);
+	virtual void beginFrame();
+	const AllocationStats &getStats(AllocationCategory::Enum category) const;
+
+	// All categories combined.
+	const AllocationStats &getTotalStats() const;
+
+private:
+	AllocationStats stats_[AllocationCategory::NumCategories];
+	AllocationStats total_;
+};
+
+// Called for each allocation made on a thread while an allocation check is active. Called at the allocation, so it can capture a stack trace. callSite is the return address of the allocating function, NULL if unknown. Allocations made by the callback aren't reported.
+typedef void (*AllocationCheckCallback)(AllocationCategory::Enum category, size_t size, const void *callSite, void *data);
+
+// Reports allocations made while a check is active, see MainWindow::setAllocationCheck.
+// Pool and NVGRenderer allocations are always seen. Other heap allocations are only seen if WidgetZero is built with WZ_CHECK_ALLOCATIONS defined, which replaces the global operator new and delete.
+class AllocationCheck
+{
+public:
+	// Activates a check on the calling thread for the lifetime of the scope. Scopes can be nested, the innermost callback is used. Does nothing if callback is NULL.
+	class Scope
+	{
+	public:
+		Scope(AllocationCheckCallback callback, void *data);
+		~Scope();
+
+	private:
+		bool active_;
+		AllocationCheckCallback previousCallback_;
+		void *previousData_;
+	};
+
+	static bool isActive();
+	static void report(AllocationCategory::Enum category, size_t size, const void *callSite);
+
+	// A callback that prints the allocation and asserts.
+	static void fail(AllocationCategory::Enum category, size_t size, const void *callSite, void *data);
+};
+
+// Allocates widgets and event handlers. Freed blocks are kept on free lists by size and reused, so building and destroying widget trees doesn't go through the general heap for every object.
+// Blocks come from the calling thread's current pool, and are always freed back to the pool they came from. Each thread has a default pool that uses malloc and is never released. A main window with an allocator pushes its own pool, see MainWindow::setAllocator.
+class Pool
+{
+public:
+	struct Arena;
+
+	static void *allocate(size_t size);
+	static void free(void *p, size_t size);
+
+	// Create a pool whose chunks and large blocks come from allocator. The pool and the blocks allocated from it must only be used on one thread.
+	static Arena *create(IAllocator *allocator);
+
+	// Return the pool's memory to its allocator. If blocks allocated from the pool are still in use, this happens when the last one is freed. The pool must have been removed.
+	static void release(Arena *pool);
+
+	// Each thread has a stack of pools, and the top one is current. Push makes pool the calling thread's current pool.
+	static void push(Arena *pool);
+
+	// Take pool off the calling thread's stack, wherever it is. If it was current, the pool pushed before it is current again.
+	static void remove(Arena *pool);
+
+	// The calling thread's current pool. NULL is the thread's default pool.
+	static Arena *getCurrent();
+};
+
+// Font face names are interned, so widgets can store a pointer instead of a copy of the name. The strings are never freed. Thread safe.
+class FontFaces
+{
+public:
+	// Returns the interned copy of fontFace. The same name always returns the same pointer.
+	static const char *intern(const char *fontFace);
+
+	// Bytes used by the interned names.
+	static size_t getMemoryUsage();
+};
+
+// See MainWindow::getMemoryStats. Sizes are in bytes.
+struct MemoryStats
+{
+	MemoryStats() : nWidgets(0), widgets(0), eventHandlers(0), strings(0), rendererCaches(0) {}
+	size_t getTotal() const { return widgets + eventHandlers + strings + rendererCaches; }
+
+	size_t nWidgets;
+
+	// Widget objects, and the arrays they use to track children and other widgets.
+	size_t widgets;
+
+	// Event handler objects and callback arrays.
+	size_t eventHandlers;
+
+	// Labels, text, ids and interned font faces. Includes any unused string capacity.
+	size_t strings;
+
+	size_t rendererCaches;
+};
+
+// A model value that widgets can be bound to. Setting a different value bumps the generation. Before the measure and layout passes, the main window compares the generation of each bound value with the one the widget last saw, so only widgets whose value actually changed are updated and dirtied.
+template<class T>
+class Bindable
+{
+public:
+	Bindable() : value_(), generation_(1) {}
+	Bindable(const T &value) : value_(value), generation_(1) {}
+
+	const T &get() const
+	{
+		return value_;
+	}
+
+	void set(const T &value)
+	{
+		if (value_ == value)
+			return;
+
+		value_ = value;
+		generation_++;
+	}
+
+	uint32_t getGeneration() const
+	{
+		return generation_;
+	}
+
+private:
+	T value_;
+	uint32_t generation_;
+};
+
 struct IEventHandler
 {
 	virtual ~IEventHandler() {}
+	static void *operator new(size_t size) { return Pool::allocate(size); }
+	static void operator delete(void *p, size_t size) { Pool::free(p, size); }
 	virtual void call(Event e) = 0;
 
+	// The size of the handler object, for memory accounting.
+	virtual size_t getSize() const = 0;
+
 	EventType::Enum eventType;
 };
 
@@ -345,6 +556,11 @@ struct EventHandler : public IEventHandler
 		WZCPP_CALL_OBJECT_METHOD(object, method)(e);
 	}
 
+	virtual size_t getSize() const
+	{
+		return sizeof(*this);
+	}
+
 	Object *object;
 	Method method;
 };
@@ -377,6 +593,9 @@ public:
 	virtual Color getLabelTextColor(Label *label);
 	virtual void drawLabel(Label *label, Rect clip);
 	virtual Size measureLabel(Label *label);
+
+	// Measure a multiline label with the text wrapped to lineWidth. Defaults to measureLabel.
+	virtual Size measureLabelWrapped(Label *label, int lineWidth);
 	virtual void drawList(List *list, Rect clip);
 	virtual Size measureList(List *list);
 	virtual void drawMenuBarButton(MenuBarButton *button, Rect clip);
@@ -414,6 +633,9 @@ public:
 	virtual void measureText(const char *fontFace, float fontSize, const char *text, int n, int *width, int *height);
 
 	virtual LineBreakResult lineBreakText(const char *fontFace, float fontSize, const char *text, int n, int lineWidth);
+
+	// Bytes used by the renderer's caches, e.g. images and fonts. Defaults to 0.
+	virtual size_t getMemoryUsage() const;
 };
 
 struct WidgetFlags
@@ -423,7 +645,46 @@ struct WidgetFlags
 		None = 0,
 		DrawLast = 1 << 0,
 		MeasureDirty = 1 << 1,
-		RectDirty = 1 << 2
+		RectDirty = 1 << 2,
+
+		// A descendant needs re-measuring. Used to skip clean subtrees in the measure pass.
+		DescendantMeasureDirty = 1 << 3,
+
+		// A descendant needs its rect recalculated. Used to skip clean subtrees in the layout pass.
+		DescendantRectDirty = 1 << 4,
+
+		// The rect or padding has changed, so the children need their rects recalculated.
+		ChildrenRectDirty = 1 << 5,
+
+		// setMeasureDirty or setRectDirty was called inside a MainWindow::beginUpdate/endUpdate scope. Propagated by endUpdate.
+		PendingMeasureDirty = 1 << 6,
+		PendingRectDirty = 1 << 7,
+
+		Hover = 1 << 8,
+
+		// Draw the widget. Set by default.
+		Visible = 1 << 9,
+
+		// Used internally to ignore siblings that overlap at the mouse cursor.
+		Ignore = 1 << 10,
+
+		// This widget should overlap other widgets when doing mouse cursor logic. e.g. tab bar scroll buttons.
+		Overlap = 1 << 11,
+
+		// Don't draw automatically when MainWindow::draw walks through the widget hierarchy.
+		DrawManually = 1 << 12,
+
+		// Clip to the parent widget rect in mouse move calculations. Set by default. Cleared by the combo widget dropdown list.
+		InputClippedToParent = 1 << 13,
+
+		// The widget is bound to a Bindable, so the main window calls refreshBinding.
+		Bound = 1 << 14,
+
+		// The widget received a mouse button press that hasn't been released, so it gets the release wherever it happens.
+		Captured = 1 << 15,
+
+		// measure reads the children's measured sizes, e.g. GroupBox, so it needs re-measuring when a child does. Implied for layout widgets.
+		MeasuredFromChildren = 1 << 16
 	};
 };
 
@@ -432,6 +693,32 @@ inline WidgetFlags::Enum operator|(WidgetFlags::Enum a, WidgetFlags::Enum b)
 	return WidgetFlags::Enum(int(a) | int(b));
 }
 
+// The input event handlers a widget overrides, see Widget::setInputEvents. The main window only calls the handlers a widget has declared, and skips subtrees that don't handle an event.
+struct InputEvents
+{
+	enum Enum
+	{
+		None = 0,
+		MouseButtonDown = 1 << 0,
+		MouseButtonUp = 1 << 1,
+		MouseMove = 1 << 2,
+		MouseWheelMove = 1 << 3,
+
+		// onMouseHoverOn and onMouseHoverOff.
+		MouseHover = 1 << 4,
+
+		KeyDown = 1 << 5,
+		KeyUp = 1 << 6,
+		TextInput = 1 << 7,
+		All = (1 << 8) - 1
+	};
+};
+
+inline InputEvents::Enum operator|(InputEvents::Enum a, InputEvents::Enum b)
+{
+	return InputEvents::Enum(int(a) | int(b));
+}
+
 class Widget
 {
 	friend class MainWindow;
@@ -439,6 +726,8 @@ class Widget
 public:
 	Widget();
 	virtual ~Widget();
+	static void *operator new(size_t size) { return Pool::allocate(size); }
+	static void operator delete(void *p, size_t size) { Pool::free(p, size); }
 	WidgetType::Enum getType() const;
 	bool isLayoutWidget() const;
 	const MainWindow *getMainWindow() const;
@@ -477,24 +766,46 @@ public:
 	float getFontSize() const;
 	void setFont(const char *fontFace, float fontSize);
 	bool getHover() const;
+
+	// Declare the input event handlers this widget overrides, replacing the events declared by base classes. Defaults to InputEvents::All. Narrowing it lets the main window skip the other handlers, and subtrees that don't handle an event.
+	void setInputEvents(InputEvents::Enum events);
+	InputEvents::Enum getInputEvents() const;
+
 	void setVisible(bool visible);
 	bool isVisible() const;
 	bool hasKeyboardFocus() const;
 	const Widget *getParent() const;
 	Widget *getParent();
 	const std::vector<Widget *> &getChildren() const;
+	// Optional. Widgets with an id can be looked up with MainWindow::find. Ids don't have to be unique.
+	void setId(const std::string &id);
+	const std::string &getId() const;
+
 	void setMetadata(void *metadata);
 	void *getMetadata();
 	void addChildWidget(Widget *child);
+
+	// Faster than calling addChildWidget for each child: the main window, window and renderer are resolved once and the dirty flags are propagated once.
+	void addChildWidgets(const std::vector<Widget *> &children);
+
 	void removeChildWidget(Widget *child);
+
+	// Remove the child and delete it along with all of its descendants.
 	void destroyChildWidget(Widget *child);
 	bool isRectDirty() const;
 	bool isMeasureDirty() const;
 	Rect getUserRect() const;
+
+	// Hidden widgets aren't measured by the measure pass, so they are measured on demand if needed.
 	Size getMeasuredSize() const;
 
+	// The measured size for the given constraints, e.g. the height of wrapped text for a width. 0 means unconstrained.
+	// Results are cached by constraint until the widget needs re-measuring.
+	Size getMeasuredSize(int availableWidth, int availableHeight);
+
 	// Returns a measured dimension if the user dimension isn't set.
 	Size getUserOrMeasuredSize() const;
+	Size getUserOrMeasuredSize(int availableWidth, int availableHeight);
 
 	void setRectInternal(Rect rect);
 	const Widget *findClosestAncestor(WidgetType::Enum type) const;
@@ -528,6 +839,9 @@ public:
 	// Shortcut for IRenderer::lineBreakText, using the widget's renderer, font face and font size.
 	LineBreakResult lineBreakText(const char *text, int n, int lineWidth) const;
 
+	// Add the memory used by this widget to stats, not including its children. Overridden by widgets that own strings, callbacks or other arrays.
+	virtual void addMemoryStats(MemoryStats *stats) const;
+
 protected:
 	virtual void doLayout();
 
@@ -542,8 +856,12 @@ protected:
 	// Some additional widget state may been to be cleared when a widget is hidden.
 	virtual void onVisibilityChanged();
 
+	// Called by the main window before the measure and layout passes if the widget is bound, see setBound. Update the widget if the bound value's generation has changed.
+	virtual void refreshBinding();
+
 	virtual void onRectChanged();
 
+	// Input event handlers. A class can declare the ones it overrides with setInputEvents in its constructor.
 	virtual void onMouseButtonDown(int mouseButton, int mouseX, int mouseY);
 	virtual void onMouseButtonUp(int mouseButton, int mouseX, int mouseY);
 	virtual void onMouseMove(int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY);
@@ -561,10 +879,40 @@ protected:
 
 	virtual Size measure();
 
+	// Override for content that depends on the constraints, e.g. the height of wrapped text depends on the width. The default ignores the constraints and returns the measured size.
+	virtual Size measureConstrained(int availableWidth, int availableHeight);
+
 	void setMeasureDirty(bool value = true);
 	void setRectDirty(bool value = true);
-	void doMeasurePassRecursive(bool dirty);
-	void doLayoutPassRecursive(bool dirty);
+
+	// Notify the parent layout, ancestors and main window. Called by setMeasureDirty and setRectDirty, or by MainWindow::endUpdate if they were called inside an update scope.
+	void propagateMeasureDirty();
+	void propagateRectDirty();
+
+	// Set RectDirty and notify the ancestors and the main window, without dirtying the parent layout.
+	void markRectDirty();
+
+	// Widgets with a fixed user size. Changes inside a relayout boundary can't affect the parent layout, so re-measuring stops at the boundary.
+	bool isRelayoutBoundary() const;
+
+	void addChildWidgetsInternal(Widget *const *children, size_t n);
+
+	bool hasFlag(WidgetFlags::Enum flag) const;
+	void setFlag(WidgetFlags::Enum flag, bool value);
+
+	// Set the Bound flag and register with the main window, so refreshBinding is called.
+	void setBound(bool bound);
+
+	// Set flag on each ancestor, stopping at the first one that already has it set.
+	void setAncestorsFlag(WidgetFlags::Enum flag);
+
+	// Recalculate the rect. Called by the main window layout pass.
+	// dirty: the parent rect, padding or position has changed.
+	// Returns true if the children need their rects recalculated.
+	bool doLayoutPass(bool dirty);
+
+	// Recalculate absoluteRect_ from the parent's absolute rect and padding. The parent's absolute rect must be up to date.
+	void refreshAbsoluteRect();
 
 	// Draw without clipping if visible.
 	void drawIfVisible();
@@ -572,8 +920,11 @@ protected:
 	void invokeEvent(Event e);
 	void invokeEvent(Event e, const std::vector<EventCallback> &callbacks);
 
-	MainWindow *findMainWindow();
 	void setRenderer(IRenderer *renderer);
+
+	// Set mainWindow_, keeping the main window id registry in sync.
+	void setMainWindow(MainWindow *mainWindow);
+
 	void setMainWindowAndWindowRecursive(MainWindow *mainWindow, Window *window);
 
 	void debugPrintf(const char *format, ...) const;
@@ -585,6 +936,9 @@ protected:
 
 	Rect rect_;
 
+	// rect_ offset by the ancestor positions and paddings. Updated by setRectInternal and the layout pass, so it is stale while the widget is hidden.
+	Rect absoluteRect_;
+
 	// Only used if the widget is the child of a layout.
 	Stretch::Enum stretch_;
 
@@ -602,29 +956,39 @@ protected:
 
 	Size measuredSize_;
 
+	struct MeasureCacheEntry
+	{
+		int availableWidth, availableHeight;
+		Size size;
+	};
+
+	// Results of measureConstrained, keyed by constraint. Cleared by setMeasureDirty.
+	MeasureCacheEntry measureCache_[2];
+	int measureCacheSize_;
+
+	// The entry to replace when the cache is full.
+	int measureCacheNext_;
+
 	// User-set metadata.
 	void *metadata_;
 
-	WidgetFlags::Enum flags_;
-
-	bool hover_;
+	std::string id_;
 
-	// Don't draw this widget if false.
-	bool visible_;
+	// Set by MainWindow when the id is registered.
+	uint32_t idHash_;
 
-	// Used internally to ignore siblings that overlap at the mouse cursor.
-	bool ignore_;
+	// The next widget in the same MainWindow id hash table bucket.
+	Widget *nextInIdBucket_;
 
-	// This widget should overlap other widgets when doing mouse cursor logic. e.g. tab bar scroll buttons.
-	bool overlap_;
+	// Index into the MainWindow layout order arrays. Set by MainWindow::refreshLayoutOrder, stale while the layout order is dirty.
+	int layoutIndex_;
 
-	// Don't draw automatically when MainWindow::draw walks through the widget hierarchy.
-	bool drawManually_;
+	WidgetFlags::Enum flags_;
 
-	// Clip to the parent widget rect in mouse move calculations. Used by the combo widget dropdown list (false).
-	bool inputClippedToParent_;
+	InputEvents::Enum inputEvents_;
 
-	char fontFace_[256];
+	// Interned, see FontFaces::intern.
+	const char *fontFace_;
 	float fontSize_;
 
 	IRenderer *renderer_;
@@ -635,13 +999,17 @@ protected:
 	Window *window_;
 
 	Widget *parent_;
+
+	// Index in parent_->children_. Only valid if parent_ is not NULL.
+	size_t childIndex_;
+
 	std::vector<Widget *> children_;
 
 	std::vector<IEventHandler *> eventHandlers_;
 
 private:
 #ifndef NDEBUG
-	void debugPrintWidgetDetailsRecursive() const;
+	void debugPrintWidgetDetailsRecursive(char *line) const;
 #endif
 };
 
@@ -692,6 +1060,7 @@ protected:
 	virtual void onMouseButtonUp(int mouseButton, int mouseX, int mouseY);
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void setClickBehavior(ButtonClickBehavior::Enum clickBehavior);
 	void setSetBehavior(ButtonSetBehavior::Enum setBehavior);
 	void click();
@@ -736,6 +1105,7 @@ protected:
 	virtual Rect getChildrenClipRect() const;
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void onListItemSelected(Event e);
 	void updateListRect();
 
@@ -779,6 +1149,7 @@ protected:
 	virtual void onRendererChanged();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void refreshPadding();
 
 	std::string label_;
@@ -797,12 +1168,20 @@ public:
 	void setTextColor(float r, float g, float b);
 	Color getTextColor() const;
 
+	// Show the value of text, updating when it changes. NULL unbinds.
+	void bindText(Bindable<std::string> *text);
+
 protected:
 	virtual void onRendererChanged();
+	virtual void refreshBinding();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
+	virtual Size measureConstrained(int availableWidth, int availableHeight);
 
 	std::string text_;
+	Bindable<std::string> *boundText_;
+	uint32_t boundGeneration_;
 	bool multiline_;
 	Color textColor_;
 	bool isTextColorUserSet_;
@@ -841,10 +1220,14 @@ public:
 	const Scroller *getScroller() const;
 	void addCallbackItemSelected(EventCallback callback);
 
+	// Keep the selected item and the bound value in sync both ways. NULL unbinds.
+	void bindSelectedItem(Bindable<int> *selectedItem);
+
 protected:
 	virtual void onRendererChanged();
 	virtual void onFontChanged(const char *fontFace, float fontSize);
 	virtual void onVisibilityChanged();
+	virtual void refreshBinding();
 	virtual void onRectChanged();
 	virtual void onMouseButtonDown(int mouseButton, int mouseX, int mouseY);
 	virtual void onMouseButtonUp(int mouseButton, int mouseX, int mouseY);
@@ -853,12 +1236,16 @@ protected:
 	virtual void onMouseHoverOff();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void onScrollerValueChanged(Event e);
 	void setItemHeightInternal(int itemHeight);
 	void refreshItemHeight();
 	void updateMouseOverItem(int mouseX, int mouseY);
 	void updateScroller();
 
+	// Copy selectedItem_ to the bound value.
+	void updateBoundSelectedItem();
+
 	Border itemsBorder_;
 	DrawListItemCallback drawItem_;
 	uint8_t *itemData_;
@@ -870,6 +1257,8 @@ protected:
 	int selectedItem_;
 	int pressedItem_;
 	int hoveredItem_;
+	Bindable<int> *boundSelectedItem_;
+	uint32_t boundGeneration_;
 
 	// The same as hoveredItem, except when pressedItem != -1.
 	int mouseOverItem_;
@@ -882,6 +1271,61 @@ protected:
 	Position lastMousePosition_;
 };
 
+struct UpdateType
+{
+	enum Enum
+	{
+		// Label::setText
+		LabelText,
+
+		// List::setNumItems
+		ListNumItems,
+
+		// List::setSelectedItem
+		ListSelectedItem,
+
+		// Scroller::setValue
+		ScrollerValue,
+
+		// Spinner::setValue
+		SpinnerValue,
+
+		// Button::set
+		ButtonSet,
+
+		// Widget::setVisible
+		WidgetVisible,
+
+		// Call a function on the main window's thread. Never coalesced.
+		Callback
+	};
+};
+
+typedef void (*UpdateCallback)(Widget *widget, void *data);
+
+// A change to a widget, posted to a main window from another thread with MainWindow::post. Updates are a fixed size, so posting doesn't allocate.
+struct Update
+{
+	// Longer text is truncated. Use a callback to set longer text.
+	enum { MaxTextLength = 95 };
+
+	static Update labelText(Label *label, const char *text);
+	static Update listNumItems(List *list, int nItems);
+	static Update listSelectedItem(List *list, int selectedItem);
+	static Update scrollerValue(Scroller *scroller, int value);
+	static Update spinnerValue(Spinner *spinner, int value);
+	static Update buttonSet(Button *button, bool value);
+	static Update widgetVisible(Widget *widget, bool visible);
+	static Update call(UpdateCallback callback, Widget *widget, void *data);
+
+	UpdateType::Enum type;
+	Widget *widget;
+	int value;
+	UpdateCallback callback;
+	void *data;
+	char text[MaxTextLength + 1];
+};
+
 struct MainWindowFlags
 {
 	enum Enum
@@ -894,7 +1338,16 @@ struct MainWindowFlags
 		AnyWidgetMeasureDirty = 1<<2,
 
 		// Used to avoid traversing the entire widget hierarchy.
-		AnyWidgetRectDirty = 1 << 3
+		AnyWidgetRectDirty = 1 << 3,
+
+		// A widget has been added or removed, so the layout order needs rebuilding.
+		LayoutOrderDirty = 1 << 4,
+
+		// When the layout time budget runs out, don't draw widgets that haven't been laid out yet. By default they are drawn with their previous rects.
+		HideIncompleteLayout = 1 << 5,
+
+		// The layout order or the main window size has changed, so the hit index needs rebuilding.
+		HitIndexDirty = 1 << 6
 	};
 };
 
@@ -903,10 +1356,16 @@ inline MainWindowFlags::Enum operator|(MainWindowFlags::Enum a, MainWindowFlags:
 	return MainWindowFlags::Enum(int(a) | int(b));
 }
 
+// A main window and its widgets must only be used by the thread that created the main window. Main windows on different threads, each with their own renderer, are independent.
 class MainWindow : public Widget
 {
 public:
-	MainWindow(IRenderer *renderer, MainWindowFlags::Enum flags = MainWindowFlags::None);
+	// If allocator is not NULL, it is set before the main window creates any widgets, see setAllocator.
+	MainWindow(IRenderer *renderer, MainWindowFlags::Enum flags = MainWindowFlags::None, IAllocator *allocator = NULL);
+
+	// Destroys every widget in the main window and releases its pool.
+	~MainWindow();
+
 	bool isDockingEnabled() const;
 	bool isMenuEnabled() const;
 	void createMenuButton(const std::string &label);
@@ -930,9 +1389,51 @@ public:
 
 	const Widget *getKeyboardFocusWidget() const;
 
+	// Find a widget in this main window's hierarchy by id. Returns NULL if there isn't one. If multiple widgets have the same id, any of them may be returned.
+	Widget *find(const std::string &id);
+
+	// Find a widget for each id. results[i] is the widget with ids[i], or NULL.
+	void findMany(const std::vector<std::string> &ids, std::vector<Widget *> *results);
+
+	// Limit the time each input event and draw call spends in the measure and layout passes. Work that doesn't fit is resumed by the next call. 0 means no limit (default).
+	void setLayoutTimeBudget(int milliseconds);
+	int getLayoutTimeBudget() const;
+
+	// False if widgets are waiting to be measured or laid out.
+	bool isLayoutComplete() const;
+
+	// Run the measure and layout passes, ignoring the time budget.
+	void finishLayout();
+
+	// Batch changes to many widgets. Inside the scope, dirty widgets are only recorded; endUpdate propagates each of them once. Scopes can be nested.
+	void beginUpdate();
+	void endUpdate();
+	bool isUpdating() const;
+
+	// True if called from the thread that created the main window.
+	bool isOwnerThread() const;
+
+	// Safe to call from any thread. The update is applied on the main window's thread before the next measure and layout passes, i.e. by the next input event or draw. Pending updates to the same widget and property are coalesced, so only the last one is applied. Returns false if the queue is full.
+	// The widget must not be destroyed while an update to it is pending.
+	bool post(const Update &update);
+
+	// The maximum number of pending updates, rounded up to a power of two. Default is 256. Don't call while other threads may be posting.
+	void setUpdateQueueCapacity(int capacity);
+	int getUpdateQueueCapacity() const;
+
+	// Report allocations made by input events and draws with callback, e.g. AllocationCheck::fail. Enable once the UI has warmed up, i.e. every widget has been created and drawn. NULL disables the check (default).
+	void setAllocationCheck(AllocationCheckCallback callback, void *data = NULL);
+
+	// If allocator is not NULL, create a pool that allocates from it and push it on the calling thread's pool stack until the main window is destroyed or the allocator is changed, see Pool::push. Widgets are allocated before they are added to a main window, so they come from the calling thread's current pool: with several main windows on one thread, that is the pool of the one that set an allocator most recently. Create each main window's widgets before creating the next main window, or use a thread per main window, to keep each in its own pool. Widgets that already exist, including the main window itself, stay in the pool they came from. Main windows can be destroyed in any order. The allocator's frame begins with each draw. NULL means malloc.
+	void setAllocator(IAllocator *allocator);
+	IAllocator *getAllocator() const;
+
 	// Set keyboard focus to this widget.
 	void setKeyboardFocusWidget(Widget *widget);
 
+	// Memory used by the widgets in this main window's hierarchy, including the main window itself, plus the renderer caches and the interned font faces.
+	MemoryStats getMemoryStats() const;
+
 	DockPosition::Enum getWindowDockPosition(const Window *window) const;
 	void dockWindow(Window *window, DockPosition::Enum dockPosition);
 	void undockWindow(Window *window);
@@ -946,37 +1447,131 @@ public:
 	// Stop locking input to this widget.
 	void popLockInputWidget(Widget *widget);
 
+	// Move the pointer capture from one widget to another, so the release goes to the widget that has taken over the press. Captures to if from isn't captured.
+	void transferCapture(Widget *from, Widget *to);
+
 	void setMovingWindow(Window *window);
 	void updateContentRect();
 
 	void setAnyWidgetMeasureDirty(bool value = true);
 	void setAnyWidgetRectDirty(bool value = true);
+	void setLayoutOrderDirty(bool value = true);
+
+	// Called by Widget when a widget with an id is added to or removed from this main window's hierarchy, or its id changes.
+	void registerWidgetId(Widget *widget);
+	void unregisterWidgetId(Widget *widget);
+
+	// Called by Widget when a bound widget is added to or removed from this main window's hierarchy, or is bound or unbound.
+	void registerBoundWidget(Widget *widget);
+	void unregisterBoundWidget(Widget *widget);
+
+	// Called by Widget::setMainWindow when a hovered widget leaves this main window. Clears the hover flag without calling onMouseHoverOff.
+	void unregisterHoverWidget(Widget *widget);
+
+	// Called by Widget::setMainWindow when a captured widget leaves this main window, so it doesn't get the release.
+	void unregisterCaptureWidget(Widget *widget);
+
+	// Call refreshBinding on each bound widget.
+	void refreshBindings();
+
+	// Called by Widget::setMeasureDirty and setRectDirty inside an update scope.
+	void addPendingDirtyWidget(Widget *widget);
+
+	// Called by Widget when its absolute rect changes. Moves the widget to the hit index cells it now overlaps.
+	void updateHitRect(Widget *widget);
+
+	// Remove widgets that are no longer in this main window's hierarchy from the pending dirty widgets.
+	void purgePendingDirtyWidgets();
 
 protected:
 	typedef bool(*WidgetPredicate)(const Widget *);
 
 	virtual void onRectChanged();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 
 	void doMeasureAndLayoutPasses();
 
+	// Drain the update queue and apply the updates that haven't been superseded.
+	void applyPostedUpdates();
+	void applyUpdate(const Update &update);
+
+	// True if the layout time budget has run out. Only checks the clock every so often.
+	bool isLayoutTimeBudgetExceeded();
+
+	// Rebuild the layout order arrays if the widget hierarchy has changed.
+	void refreshLayoutOrder();
+
+	// Returns false if the time budget ran out before every widget was measured. The widgets that weren't measured are left flagged for the next pass.
+	bool doMeasurePass();
+
+	void doLayoutPass();
+
+	// The layout pass ran out of time after laying out the widget before stop. Mark the widgets after it that still need their rects recalculated, so the next pass resumes from there.
+	void deferLayout(int stop);
+
+	// Rebuild the hit index if the layout order or the main window size has changed.
+	void refreshHitIndex();
+
+	// Add or remove the layout order index from the hit index cells that rect overlaps.
+	void addHitRect(int index, Rect rect);
+	void removeHitRect(int index, Rect rect);
+
+	// Set indices to the layout order indices of the widgets whose absolute rect contains the point, in layout order. The layout order must be up to date.
+	void hitTest(int x, int y, std::vector<int> *indices);
+
 	void mouseButtonDownRecursive(Widget *widget, int mouseButton, int mouseX, int mouseY);
-	void mouseButtonUpRecursive(Widget *widget, int mouseButton, int mouseX, int mouseY);
+
+	// Call onMouseButtonDown and capture the pointer for the widget.
+	void pressWidget(Widget *widget, int mouseButton, int mouseX, int mouseY);
+
+	// Clear the captured widgets. Called when all mouse buttons have been released.
+	void releaseCapture();
+
+	// Set widgets to the widgets mouseButtonDownRecursive would visit from root that handle any of events: root, and its visible hovered descendants whose ancestors up to root are visible and hovered too. In layout order. Returns false if the layout order can't be used.
+	bool collectHoverPath(Widget *root, InputEvents::Enum events, std::vector<Widget *> *widgets);
+
+	// The layout order is up to date and includes the widget.
+	bool isInLayoutOrder(const Widget *widget) const;
+
+	// The widget or any of its descendants handle any of events. True if the layout order can't be used.
+	bool subtreeHandlesInputEvents(const Widget *widget, InputEvents::Enum events) const;
 
 	// Clear widget hover on everything but ignoreWindow and it's children.
-	void clearHoverRecursive(Window *ignoreWindow, Widget *widget);
+	void clearHover(Window *ignoreWindow);
+
+	// Set the widget's hover flag, calling onMouseHoverOn or onMouseHoverOff if it changed. Keeps hoverWidgets_ in sync.
+	void setWidgetHover(Widget *widget, bool hover);
+
+	// The widget is window or one of its children. Always true if window is NULL.
+	bool isChildOfWindow(const Window *window, const Widget *widget) const;
 
 	// Sets Widget.ignore
 	void ignoreOverlappingChildren(Widget *widget, int mouseX, int mouseY);
 
+	// Same as ignoreOverlappingChildren, but for every parent of the widgets in hitIndices_ at once, looking only at the children in hitIndices_. The flag on the widget at layout order index root is left alone.
+	void ignoreOverlappingHitIndices(int root, int mouseX, int mouseY);
+
 	// If window is not NULL, only call onMouseMove in widgets that are children of the window and the window itself.
 	void mouseMoveRecursive(Window *window, Widget *widget, int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY);
 
+	// Same as mouseMoveRecursive from root, but only visits root, the widgets in it under the mouse cursor, found with the hit index, and the widgets in it that are hovered.
+	void mouseMoveHitPath(Widget *root, Window *window, int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY);
+
+	// Whether the mouse cursor is hovering over the widget, ignoring visibility and overlap. If window is not NULL, only it and its children can be hovered.
+	bool calculateWidgetHover(Window *window, const Widget *widget, int mouseX, int mouseY) const;
+
+	// Update hover and call onMouseMove for a single widget. Returns false if the widget's children shouldn't be visited.
+	bool mouseMoveWidget(Window *window, Widget *widget, int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY);
+
 	void mouseWheelMoveRecursive(Widget *widget, int x, int y);
 
 	void keyDelta(Key::Enum key, bool down);
 	void drawWidgetRecursive(Widget *widget, Rect clip, WidgetPredicate drawPredicate, WidgetPredicate recursePredicate);
 	void drawWidget(Widget *widget, WidgetPredicate drawPredicate, WidgetPredicate recursePredicate);
 
+	// The widget hasn't been laid out yet and MainWindowFlags::HideIncompleteLayout is set.
+	bool isWidgetLayoutHidden(const Widget *widget) const;
+
 	// Returns the window that the mouse cursor is hovering over. NULL if there isn't one.
 	Window *getHoverWindow(int mouseX, int mouseY);
 
@@ -999,6 +1594,104 @@ protected:
 
 	MainWindowFlags::Enum flags_;
 
+	// Widget id hash table. Each bucket is a list chained through Widget::nextInIdBucket_. The number of buckets is a power of two.
+	std::vector<Widget *> idBuckets_;
+	size_t nIdWidgets_;
+
+	std::vector<Widget *> boundWidgets_;
+
+	// Nesting depth of beginUpdate/endUpdate.
+	int updateDepth_;
+
+	// Identifies the thread that created the main window, see isOwnerThread.
+	const void *ownerThread_;
+
+	IAllocator *allocator_;
+
+	// Created and pushed by setAllocator. NULL if there is no allocator.
+	Pool::Arena *pool_;
+
+	AllocationCheckCallback allocationCheckCallback_;
+	void *allocationCheckData_;
+
+	// A bounded multiple producer, single consumer queue. Each cell's sequence says whether it is ready to be written (== position) or read (== position + 1).
+	struct UpdateQueueCell
+	{
+		volatile long sequence;
+		Update update;
+	};
+
+	std::vector<UpdateQueueCell> updateQueue_;
+
+	// The next position to post to. Shared by the posting threads.
+	volatile long updateQueueHead_;
+
+	// The next position to apply. Only used by the main window's thread.
+	long updateQueueTail_;
+
+	// Reused by applyPostedUpdates.
+	std::vector<Update> postedUpdates_;
+	std::vector<int> keptUpdates_;
+	std::vector<const Update *> updateCoalesceTable_;
+
+	// In milliseconds. 0 if there is no limit.
+	int layoutTimeBudget_;
+
+	// When the current measure and layout passes have to stop, in microseconds on a monotonic clock.
+	uint64_t layoutDeadline_;
+
+	// Counts down the widgets until the clock is checked again.
+	int layoutBudgetCheckCountdown_;
+
+	// Widgets with PendingMeasureDirty or PendingRectDirty set.
+	std::vector<Widget *> pendingDirtyWidgets_;
+
+	// The widget hierarchy flattened in pre-order, so the measure and layout passes are linear sweeps instead of recursing through children. Indexed by layout order.
+	std::vector<Widget *> layoutWidgets_;
+
+	// The layout order index of each widget's parent. -1 for the main window.
+	std::vector<int> layoutParents_;
+
+	// One past the layout order index of each widget's last descendant. Used to skip subtrees.
+	std::vector<int> layoutSubtreeEnds_;
+
+	// The input events handled by each widget and its descendants. Used to skip subtrees that can't react to an event.
+	std::vector<InputEvents::Enum> layoutSubtreeInputEvents_;
+
+	// Written by the layout pass: the widget's children need their rects recalculated.
+	std::vector<bool> layoutChildrenDirty_;
+
+	// Widgets that need re-measuring, in layout order. Measured in reverse order so children are measured before their parents.
+	std::vector<Widget *> measureWidgets_;
+
+	// A uniform grid over the main window. Each cell lists the layout order indices of the widgets whose absolute rect overlaps it, so pointer hit tests only look at the widgets near the cursor.
+	std::vector<std::vector<int> > hitCells_;
+	int hitColumns_, hitRows_;
+
+	// The absolute rect each widget is indexed with. Indexed by layout order.
+	std::vector<Rect> hitRects_;
+
+	// Reused by mouseMoveHitPath and getHoverWindow.
+	std::vector<int> hitIndices_;
+
+	// The new hover state of each widget in hitIndices_. Used by mouseMoveHitPath.
+	std::vector<uint8_t> hitHoverStates_;
+
+	// The widgets with the hover flag set, in the order they started hovering. Hover changes are diffed against these, instead of clearing hover on every widget.
+	std::vector<Widget *> hoverWidgets_;
+
+	// Reused by mouseButtonDown and mouseWheelMove. See collectHoverPath.
+	std::vector<Widget *> hoverPath_;
+
+	// The widgets that received a mouse button press, in the order they received it. The release is routed to these instead of the whole hierarchy. NULL entries are widgets that have been removed since.
+	std::vector<Widget *> captureWidgets_;
+
+	// One bit per mouse button that is held down.
+	int pressedMouseButtons_;
+
+	// Two per layout order index: the number of children under the cursor that are set to overlap, and how many of those are visible. Zero outside ignoreOverlappingHitIndices.
+	std::vector<int> hitOverlapCounts_;
+
 	Widget *content_;
 
 	bool isTextCursorVisible_;
@@ -1048,6 +1741,7 @@ protected:
 	virtual void onMouseHoverOn();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 
 	Border padding_;
 	std::string label_;
@@ -1067,6 +1761,7 @@ protected:
 	virtual void onRendererChanged();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 
 	StackLayout *layout_;
 };
@@ -1094,6 +1789,7 @@ protected:
 	virtual void onMouseButtonDown(int mouseButton, int mouseX, int mouseY);
 	virtual void onMouseButtonUp(int mouseButton, int mouseX, int mouseY);
 	virtual void onMouseMove(int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY);
+	virtual void addMemoryStats(MemoryStats *stats) const;
 
 	Scroller *scroller_;
 	bool isPressed_;
@@ -1134,11 +1830,16 @@ public:
 	void getNubState(Rect *containerRect, Rect *rect, bool *hover, bool *pressed) const;
 	void addCallbackValueChanged(EventCallback callback);
 
+	// Keep the scroller value and the bound value in sync both ways. NULL unbinds.
+	void bindValue(Bindable<int> *value);
+
 protected:
 	virtual void onRectChanged();
 	virtual void onMouseWheelMove(int x, int y);
+	virtual void refreshBinding();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void onDecrementButtonClicked(Event e);
 	void onIncrementButtonClicked(Event e);
 
@@ -1148,6 +1849,8 @@ protected:
 	Button *decrementButton_, *incrementButton_;
 	ScrollerNub *nub_;
 	std::vector<EventCallback> valueChangedCallbacks_;
+	Bindable<int> *boundValue_;
+	uint32_t boundGeneration_;
 };
 
 class SpinnerDecrementButton;
@@ -1162,17 +1865,24 @@ public:
 	TextEdit *getTextEdit();
 	const TextEdit *getTextEdit() const;
 
+	// Keep the spinner value and the bound value in sync both ways. NULL unbinds.
+	void bindValue(Bindable<int> *value);
+
 protected:
 	virtual void onRendererChanged();
 	virtual void onFontChanged(const char *fontFace, float fontSize);
+	virtual void refreshBinding();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void onDecrementButtonClicked(Event e);
 	void onIncrementButtonClicked(Event e);
 
 	TextEdit *textEdit_;
 	SpinnerDecrementButton *decrementButton_;
 	SpinnerIncrementButton *incrementButton_;
+	Bindable<int> *boundValue_;
+	uint32_t boundGeneration_;
 };
 
 struct StackLayoutDirection
@@ -1192,11 +1902,13 @@ public:
 	void setSpacing(int spacing);
 	int getSpacing() const;
 	void add(Widget *widget);
+	void add(const std::vector<Widget *> &widgets);
 	void remove(Widget *widget);
 
 protected:
 	virtual void doLayout();
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void layoutVertical();
 	void layoutHorizontal();
 
@@ -1232,6 +1944,7 @@ protected:
 	virtual void onRectChanged();
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 
 	// Sets the scroll value, and repositions and shows/hides the tabs accordingly.
 	void setScrollValue(int value);
@@ -1267,6 +1980,10 @@ public:
 	void remove(Widget *widget);
 };
 
+class Tab;
+
+typedef void (*TabPageFactory)(Tab *tab);
+
 // Wraps tab button and page.
 class Tab
 {
@@ -1280,9 +1997,26 @@ public:
 	Widget *add(Widget *widget);
 	void remove(Widget *widget);
 
+	// Create the page's widgets the first time the tab is selected, instead of up front. The factory adds them with Tab::add.
+	void setPageFactory(TabPageFactory factory);
+
+	// False if the page factory hasn't been called yet.
+	bool isPageCreated() const;
+
+	void setMetadata(void *metadata);
+	void *getMetadata();
+
 protected:
+	// Call the page factory if it hasn't been called yet.
+	void createPage();
+
 	TabButton *button_;
 	TabPage *page_;
+	TabPageFactory pageFactory_;
+	bool isPageCreated_;
+
+	// User-set metadata.
+	void *metadata_;
 };
 
 class Tabbed : public Widget
@@ -1295,6 +2029,7 @@ public:
 protected:
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void onTabChanged(Event e);
 
 	StackLayout *layout_;
@@ -1339,9 +2074,13 @@ public:
 	// Calculate the position of the index - relative to text rect - based on the cursor index and scroll index. 
 	Position positionFromIndex(int index) const;
 
+	// Keep the text and the bound text in sync both ways. NULL unbinds.
+	void bindText(Bindable<std::string> *text);
+
 protected:
 	virtual void onRendererChanged();
 	virtual void onRectChanged();
+	virtual void refreshBinding();
 	virtual void onMouseButtonDown(int mouseButton, int mouseX, int mouseY);
 	virtual void onMouseButtonUp(int mouseButton, int mouseX, int mouseY);
 	virtual void onMouseMove(int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY);
@@ -1350,6 +2089,7 @@ protected:
 	virtual void onTextInput(const char *text);
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 	void onScrollerValueChanged(Event e);
 	int calculateNumLines(int lineWidth);
 	void updateScroller();
@@ -1358,6 +2098,9 @@ protected:
 	void deleteText(int index, int n);
 	void deleteSelectedText();
 
+	// Copy text_ to the bound text.
+	void updateBoundText();
+
 	// Returns -1 if an index could not be calculated. e.g. if the position is outside the widget.
 	int indexFromRelativePosition(Position pos) const;
 
@@ -1380,6 +2123,8 @@ protected:
 	int selectionStartIndex_;
 	int selectionEndIndex_;
 	std::string text_;
+	Bindable<std::string> *boundText_;
+	uint32_t boundGeneration_;
 };
 
 class ToggleButton : public Button
@@ -1449,6 +2194,7 @@ protected:
 	virtual Rect getChildrenClipRect() const;
 	virtual void draw(Rect clip);
 	virtual Size measure();
+	virtual void addMemoryStats(MemoryStats *stats) const;
 
 	void refreshHeaderHeightAndPadding();
 
@@ -1475,4 +2221,87 @@ protected:
 	Size sizeBeforeDocking_;
 };
 
+namespace im {
+
+// An immediate-mode facade over the retained widgets. Describe the UI every frame between begin and end; each call is matched to the widget it created on a previous frame by id, or by its position among the calls of the same type in its stack if there is no id. Labels and text are properties, so text that changes every frame, e.g. a counter, updates the same widget. Only changed properties are applied to matched widgets, and widgets are only created or destroyed when the structure changes, so a frame that describes the same UI as the last one creates no widgets and dirties nothing.
+class Context
+{
+public:
+	// Widgets are added to parent. Destroy the context before the parent.
+	Context(Widget *parent);
+	~Context();
+	void begin();
+	void end();
+
+	// Returns true if the button was clicked since the last frame.
+	bool button(const char *label, const char *id = NULL);
+
+	void label(const char *text, const char *id = NULL);
+
+	// Returns true if the user changed value since the last frame.
+	bool checkBox(const char *label, bool *value, const char *id = NULL);
+
+	// Calls between beginStack and endStack are added to a stack layout.
+	void beginStack(StackLayoutDirection::Enum direction, int spacing = 0, const char *id = NULL);
+	void endStack();
+
+	// The number of widgets created and destroyed by the last frame.
+	int getNumCreated() const;
+	int getNumDestroyed() const;
+
+private:
+	struct NodeType
+	{
+		enum Enum
+		{
+			Root,
+			Button,
+			CheckBox,
+			Label,
+			Stack
+		};
+	};
+
+	struct Node
+	{
+		NodeType::Enum type;
+		uint32_t hash;
+		std::string key;
+		Widget *widget;
+		int frame;
+		int direction;
+
+		// Containers only. Child nodes in the order of the last frame, and in the order of this frame so far.
+		std::vector<int> children;
+		std::vector<int> order;
+		size_t cursor;
+		bool created;
+		bool reordered;
+	};
+
+	int match(NodeType::Enum type, const char *key);
+	int createNode(NodeType::Enum type, const char *key, Widget *widget);
+	void endContainer(int index);
+	void freeNode(int index);
+	bool wasClicked(Widget *widget) const;
+	void onButtonClicked(Event e);
+
+	Widget *parent_;
+	std::vector<Node> nodes_;
+	std::vector<int> freeNodes_;
+	std::vector<int> stack_;
+	std::vector<Widget *> clicked_;
+	int frame_;
+	bool ignoreClicks_;
+	int nCreated_;
+	int nDestroyed_;
+};
+
+} // namespace im
 } // namespace wz
+
+#define WZ_IM_STRINGIFY2(x) #x
+#define WZ_IM_STRINGIFY(x) WZ_IM_STRINGIFY2(x)
+
+// An id unique to the call site, for immediate-mode calls that come and go between frames, so the calls after them keep their widgets and state.
+#define WZ_IM_ID __FILE__ ":" WZ_IM_STRINGIFY(__LINE__)
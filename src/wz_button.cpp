@@ -29,6 +29,7 @@ namespace wz {
 Button::Button(const std::string &label, const std::string &icon)
 {
 	type_ = WidgetType::Button;
+	setInputEvents(InputEvents::MouseButtonDown | InputEvents::MouseButtonUp);
 	clickBehavior_ = ButtonClickBehavior::Up;
 	setBehavior_ = ButtonSetBehavior::Default;
 	isPressed_ = isSet_ = false;
@@ -148,7 +149,7 @@ void Button::onMouseButtonUp(int mouseButton, int /*mouseX*/, int /*mouseY*/)
 		isPressed_ = false;
 		mainWindow_->popLockInputWidget(this);
 
-		if (hover_ && clickBehavior_ == ButtonClickBehavior::Up)
+		if (getHover() && clickBehavior_ == ButtonClickBehavior::Up)
 		{
 			click();
 		}
@@ -165,6 +166,14 @@ Size Button::measure()
 	return renderer_->measureButton(this);
 }
 
+void Button::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(Button) - sizeof(Widget);
+	stats->eventHandlers += (pressedCallbacks_.capacity() + clickedCallbacks_.capacity()) * sizeof(EventCallback);
+	stats->strings += label_.capacity() + icon_.capacity();
+}
+
 void Button::setClickBehavior(ButtonClickBehavior::Enum clickBehavior)
 {
 	clickBehavior_ = clickBehavior;
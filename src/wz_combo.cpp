@@ -29,6 +29,7 @@ namespace wz {
 Combo::Combo(uint8_t *itemData, int itemStride, int nItems)
 {
 	type_ = WidgetType::Combo;
+	setInputEvents(InputEvents::MouseButtonDown);
 	isOpen_ = false;
 
 	list_ = new List(itemData, itemStride, nItems);
@@ -119,6 +120,12 @@ Size Combo::measure()
 	return renderer_->measureCombo(this);
 }
 
+void Combo::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(Combo) - sizeof(Widget);
+}
+
 void Combo::onListItemSelected(Event)
 {
 	// Unlock input.
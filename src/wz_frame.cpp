@@ -29,6 +29,7 @@ namespace wz {
 Frame::Frame()
 {
 	type_ = WidgetType::Frame;
+	setInputEvents(InputEvents::None);
 }
 
 void Frame::add(Widget *widget)
@@ -29,6 +29,10 @@ namespace wz {
 GroupBox::GroupBox(const std::string &label) : label_(label)
 {
 	type_ = WidgetType::GroupBox;
+	setInputEvents(InputEvents::None);
+
+	// The measured size includes the content widget.
+	setFlag(WidgetFlags::MeasuredFromChildren, true);
 }
 
 void GroupBox::setLabel(const char *label)
@@ -91,6 +95,13 @@ Size GroupBox::measure()
 	return Size(WZ_MAX(content.w, measured.w), WZ_MAX(content.h, measured.h));
 }
 
+void GroupBox::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(GroupBox) - sizeof(Widget);
+	stats->strings += label_.capacity();
+}
+
 void GroupBox::refreshPadding()
 {
 	Border margin = renderer_->getGroupBoxMargin(this);
@@ -0,0 +1,424 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014 Jonathan Young
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "wz.h"
+#pragma hdrstop
+
+namespace wz {
+namespace im {
+
+static uint32_t HashKey(const char *key)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+
+	for (const char *c = key; *c; c++)
+	{
+		hash = (hash ^ (uint8_t)*c) * 16777619u;
+	}
+
+	return hash;
+}
+
+static void AddChild(Widget *container, Widget *child)
+{
+	if (container->getType() == WidgetType::MainWindow)
+	{
+		((MainWindow *)container)->add(child);
+	}
+	else if (container->getType() == WidgetType::Window)
+	{
+		((Window *)container)->add(child);
+	}
+	else if (container->getType() == WidgetType::StackLayout)
+	{
+		((StackLayout *)container)->add(child);
+	}
+	else
+	{
+		container->addChildWidget(child);
+	}
+}
+
+Context::Context(Widget *parent) : parent_(parent), frame_(0), ignoreClicks_(false), nCreated_(0), nDestroyed_(0)
+{
+	WZ_ASSERT(parent);
+
+	// The root node stands in for the parent widget.
+	createNode(NodeType::Root, "", parent);
+}
+
+Context::~Context()
+{
+	const std::vector<int> &children = nodes_[0].children;
+
+	for (size_t i = 0; i < children.size(); i++)
+	{
+		Widget *widget = nodes_[children[i]].widget;
+		widget->getParent()->destroyChildWidget(widget);
+	}
+}
+
+void Context::begin()
+{
+	WZ_ASSERT(stack_.empty());
+	frame_++;
+	nCreated_ = nDestroyed_ = 0;
+	nodes_[0].frame = frame_;
+	nodes_[0].cursor = 0;
+	nodes_[0].created = nodes_[0].reordered = false;
+	nodes_[0].order.clear();
+	stack_.push_back(0);
+
+	if (parent_->getMainWindow())
+	{
+		parent_->getMainWindow()->beginUpdate();
+	}
+}
+
+void Context::end()
+{
+	WZ_ASSERT(stack_.size() == 1);
+	endContainer(0);
+	stack_.pop_back();
+
+	// Clicks are reported by the first frame after they happen.
+	clicked_.clear();
+
+	if (parent_->getMainWindow())
+	{
+		parent_->getMainWindow()->endUpdate();
+	}
+}
+
+bool Context::button(const char *label, const char *id)
+{
+	WZ_ASSERT(label);
+
+	// Without an id, match by position. The label is a property.
+	const char *key = id ? id : "";
+	int index = match(NodeType::Button, key);
+	Button *button;
+
+	if (index == -1)
+	{
+		button = new Button(label);
+		button->addEventHandler(EventType::ButtonClicked, this, &Context::onButtonClicked);
+		createNode(NodeType::Button, key, button);
+		return false;
+	}
+
+	button = (Button *)nodes_[index].widget;
+
+	if (strcmp(button->getLabel(), label) != 0)
+	{
+		button->setLabel(label);
+	}
+
+	return wasClicked(button);
+}
+
+void Context::label(const char *text, const char *id)
+{
+	WZ_ASSERT(text);
+
+	// Without an id, match by position. The text is a property, e.g. a counter that changes every frame.
+	const char *key = id ? id : "";
+	int index = match(NodeType::Label, key);
+
+	if (index == -1)
+	{
+		createNode(NodeType::Label, key, new Label(text));
+		return;
+	}
+
+	Label *label = (Label *)nodes_[index].widget;
+
+	if (strcmp(label->getText(), text) != 0)
+	{
+		label->setText(text);
+	}
+}
+
+bool Context::checkBox(const char *label, bool *value, const char *id)
+{
+	WZ_ASSERT(label);
+	WZ_ASSERT(value);
+
+	// Without an id, match by position. The label is a property.
+	const char *key = id ? id : "";
+	int index = match(NodeType::CheckBox, key);
+	CheckBox *checkBox;
+
+	if (index == -1)
+	{
+		checkBox = new CheckBox(label);
+		checkBox->check(*value);
+		checkBox->addEventHandler(EventType::ButtonClicked, this, &Context::onButtonClicked);
+		createNode(NodeType::CheckBox, key, checkBox);
+		return false;
+	}
+
+	checkBox = (CheckBox *)nodes_[index].widget;
+
+	if (strcmp(checkBox->getLabel(), label) != 0)
+	{
+		checkBox->setLabel(label);
+	}
+
+	// The user's click wins over the value passed in.
+	if (wasClicked(checkBox))
+	{
+		*value = checkBox->isChecked();
+		return true;
+	}
+
+	if (checkBox->isChecked() != *value)
+	{
+		// Checking fires the clicked event, don't report it as a click.
+		ignoreClicks_ = true;
+		checkBox->check(*value);
+		ignoreClicks_ = false;
+	}
+
+	return false;
+}
+
+void Context::beginStack(StackLayoutDirection::Enum direction, int spacing, const char *id)
+{
+	const char *key = id ? id : "";
+	int index = match(NodeType::Stack, key);
+
+	if (index == -1)
+	{
+		index = createNode(NodeType::Stack, key, new StackLayout(direction, spacing));
+		nodes_[index].direction = direction;
+	}
+	else
+	{
+		StackLayout *stack = (StackLayout *)nodes_[index].widget;
+
+		if (nodes_[index].direction != direction)
+		{
+			stack->setDirection(direction);
+			nodes_[index].direction = direction;
+		}
+
+		if (stack->getSpacing() != spacing)
+		{
+			stack->setSpacing(spacing);
+		}
+	}
+
+	Node &node = nodes_[index];
+	node.cursor = 0;
+	node.created = node.reordered = false;
+	node.order.clear();
+	stack_.push_back(index);
+}
+
+void Context::endStack()
+{
+	WZ_ASSERT(stack_.size() > 1);
+	endContainer(stack_.back());
+	stack_.pop_back();
+}
+
+int Context::getNumCreated() const
+{
+	return nCreated_;
+}
+
+int Context::getNumDestroyed() const
+{
+	return nDestroyed_;
+}
+
+int Context::match(NodeType::Enum type, const char *key)
+{
+	Node &container = nodes_[stack_.back()];
+	const uint32_t hash = HashKey(key);
+	const std::vector<int> &children = container.children;
+	int index = -1;
+
+	// Fast path: the same call as at this position last frame.
+	if (container.cursor < children.size())
+	{
+		const Node &node = nodes_[children[container.cursor]];
+
+		if (node.frame != frame_ && node.type == type && node.hash == hash && node.key == key)
+		{
+			index = children[container.cursor];
+			container.cursor++;
+		}
+	}
+
+	// Something was inserted, removed or moved. Search for the first unused match, so calls with the same key are matched in order.
+	if (index == -1)
+	{
+		for (size_t i = 0; i < children.size(); i++)
+		{
+			const Node &node = nodes_[children[i]];
+
+			if (node.frame != frame_ && node.type == type && node.hash == hash && node.key == key)
+			{
+				index = children[i];
+
+				// Matched a node before the cursor: it has moved.
+				if (i < container.cursor)
+				{
+					container.reordered = true;
+				}
+
+				container.cursor = i + 1;
+				break;
+			}
+		}
+	}
+
+	if (index == -1)
+		return -1;
+
+	// A node created earlier this frame was added after this one, but should come before it.
+	if (container.created)
+	{
+		container.reordered = true;
+	}
+
+	nodes_[index].frame = frame_;
+	container.order.push_back(index);
+	return index;
+}
+
+int Context::createNode(NodeType::Enum type, const char *key, Widget *widget)
+{
+	int index;
+
+	if (freeNodes_.empty())
+	{
+		index = (int)nodes_.size();
+		nodes_.push_back(Node());
+	}
+	else
+	{
+		index = freeNodes_.back();
+		freeNodes_.pop_back();
+	}
+
+	Node &node = nodes_[index];
+	node.type = type;
+	node.hash = HashKey(key);
+	node.key = key;
+	node.widget = widget;
+	node.frame = frame_;
+	node.direction = 0;
+	node.children.clear();
+	node.order.clear();
+	node.cursor = 0;
+	node.created = node.reordered = false;
+
+	if (type != NodeType::Root)
+	{
+		Node &container = nodes_[stack_.back()];
+		container.order.push_back(index);
+		container.created = true;
+		AddChild(container.widget, widget);
+		nCreated_++;
+	}
+
+	return index;
+}
+
+void Context::endContainer(int index)
+{
+	Node &container = nodes_[index];
+
+	// Destroy the widgets of nodes that weren't called this frame.
+	for (size_t i = 0; i < container.children.size(); i++)
+	{
+		const int child = container.children[i];
+
+		if (nodes_[child].frame != frame_)
+		{
+			Widget *widget = nodes_[child].widget;
+			widget->getParent()->destroyChildWidget(widget);
+			freeNode(child);
+		}
+	}
+
+	// New widgets were added at the end, and moved widgets are still in their old place. Re-add the widgets in call order.
+	if (container.reordered)
+	{
+		for (size_t i = 0; i < container.order.size(); i++)
+		{
+			Widget *widget = nodes_[container.order[i]].widget;
+			widget->getParent()->removeChildWidget(widget);
+		}
+
+		for (size_t i = 0; i < container.order.size(); i++)
+		{
+			AddChild(container.widget, nodes_[container.order[i]].widget);
+		}
+	}
+
+	// Swapping keeps the capacity of both vectors, so the next frame doesn't allocate.
+	container.children.swap(container.order);
+}
+
+void Context::freeNode(int index)
+{
+	// The widget subtree has already been destroyed, free the descendant nodes too.
+	Node &node = nodes_[index];
+
+	for (size_t i = 0; i < node.children.size(); i++)
+	{
+		freeNode(node.children[i]);
+	}
+
+	node.widget = NULL;
+	node.frame = -1;
+	freeNodes_.push_back(index);
+	nDestroyed_++;
+}
+
+bool Context::wasClicked(Widget *widget) const
+{
+	for (size_t i = 0; i < clicked_.size(); i++)
+	{
+		if (clicked_[i] == widget)
+			return true;
+	}
+
+	return false;
+}
+
+void Context::onButtonClicked(Event e)
+{
+	if (!ignoreClicks_)
+	{
+		clicked_.push_back(e.button.button);
+	}
+}
+
+} // namespace im
+} // namespace wz
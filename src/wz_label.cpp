@@ -29,8 +29,11 @@ namespace wz {
 Label::Label(const std::string &text) : text_(text), textColor_(1, 1, 1)
 {
 	type_ = WidgetType::Label;
+	setInputEvents(InputEvents::None);
 	multiline_ = false;
 	isTextColorUserSet_ = false;
+	boundText_ = NULL;
+	boundGeneration_ = 0;
 }
 
 void Label::setMultiline(bool multiline)
@@ -51,7 +54,7 @@ void Label::setText(const char *text)
 
 void Label::setTextf(const char *format, ...)
 {
-	static char buffer[1024];
+	char buffer[1024];
 
 	va_list args;
 	va_start(args, format);
@@ -83,6 +86,27 @@ Color Label::getTextColor() const
 	return textColor_;
 }
 
+void Label::bindText(Bindable<std::string> *text)
+{
+	boundText_ = text;
+	setBound(text != NULL);
+
+	if (text)
+	{
+		boundGeneration_ = text->getGeneration();
+		setText(text->get().c_str());
+	}
+}
+
+void Label::refreshBinding()
+{
+	if (boundText_->getGeneration() == boundGeneration_)
+		return;
+
+	boundGeneration_ = boundText_->getGeneration();
+	setText(boundText_->get().c_str());
+}
+
 void Label::onRendererChanged()
 {
 	if (!isTextColorUserSet_)
@@ -101,4 +125,20 @@ Size Label::measure()
 	return renderer_->measureLabel(this);
 }
 
+Size Label::measureConstrained(int availableWidth, int availableHeight)
+{
+	// Only wrapped text depends on the width.
+	if (!multiline_ || availableWidth <= 0)
+		return Widget::measureConstrained(availableWidth, availableHeight);
+
+	return renderer_->measureLabelWrapped(this, availableWidth);
+}
+
+void Label::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(Label) - sizeof(Widget);
+	stats->strings += text_.capacity();
+}
+
 } // namespace wz
@@ -29,12 +29,15 @@ namespace wz {
 List::List(uint8_t *itemData, int itemStride, int nItems)
 {
 	type_ = WidgetType::List;
+	setInputEvents(InputEvents::MouseButtonDown | InputEvents::MouseButtonUp | InputEvents::MouseMove | InputEvents::MouseWheelMove | InputEvents::MouseHover);
 	drawItem_ = NULL;
 	itemHeight_ = 0;
 	isItemHeightUserSet_ = false;
 	firstItem_ = 0;
 	selectedItem_ = pressedItem_ = hoveredItem_ = mouseOverItem_ = -1;
 	scroller_ = NULL;
+	boundSelectedItem_ = NULL;
+	boundGeneration_ = 0;
 	itemsBorder_.top = itemsBorder_.right = itemsBorder_.bottom = itemsBorder_.left = 2;
 
 	itemData_ = itemData;
@@ -144,6 +147,7 @@ int List::getFirstItem() const
 void List::setSelectedItem(int selectedItem)
 {
 	selectedItem_ = selectedItem;
+	updateBoundSelectedItem();
 	
 	Event e;
 	e.list.type = EventType::ListItemSelected;
@@ -187,6 +191,18 @@ void List::addCallbackItemSelected(EventCallback callback)
 	itemSelectedCallbacks_.push_back(callback);
 }
 
+void List::bindSelectedItem(Bindable<int> *selectedItem)
+{
+	boundSelectedItem_ = selectedItem;
+	setBound(selectedItem != NULL);
+
+	if (selectedItem)
+	{
+		boundGeneration_ = selectedItem->getGeneration();
+		setSelectedItem(selectedItem->get());
+	}
+}
+
 void List::onRendererChanged()
 {
 	refreshItemHeight();
@@ -210,6 +226,19 @@ void List::onVisibilityChanged()
 	}
 }
 
+void List::refreshBinding()
+{
+	if (boundSelectedItem_->getGeneration() == boundGeneration_)
+		return;
+
+	boundGeneration_ = boundSelectedItem_->getGeneration();
+
+	if (selectedItem_ != boundSelectedItem_->get())
+	{
+		setSelectedItem(boundSelectedItem_->get());
+	}
+}
+
 void List::onRectChanged()
 {
 	updateScroller();
@@ -234,6 +263,7 @@ void List::onMouseButtonUp(int mouseButton, int mouseX, int mouseY)
 		if (pressedItem_ != -1)
 		{
 			selectedItem_ = pressedItem_;
+			updateBoundSelectedItem();
 			selectedItemAssignedTo = true;
 			pressedItem_ = -1;
 		}
@@ -300,6 +330,13 @@ Size List::measure()
 	return renderer_->measureList(this);
 }
 
+void List::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(List) - sizeof(Widget);
+	stats->eventHandlers += itemSelectedCallbacks_.capacity() * sizeof(EventCallback);
+}
+
 void List::onScrollerValueChanged(Event e)
 {
 	firstItem_ = e.scroller.value / itemHeight_;
@@ -326,7 +363,7 @@ void List::updateMouseOverItem(int mouseX, int mouseY)
 {
 	mouseOverItem_ = -1;
 
-	if (!hover_)
+	if (!getHover())
 		return;
 
 	const Rect itemsRect = getAbsoluteItemsRect();
@@ -379,4 +416,13 @@ void List::updateScroller()
 	scroller_->setVisible(max > 0);
 }
 
+void List::updateBoundSelectedItem()
+{
+	if (boundSelectedItem_)
+	{
+		boundSelectedItem_->set(selectedItem_);
+		boundGeneration_ = boundSelectedItem_->getGeneration();
+	}
+}
+
 } // namespace wz
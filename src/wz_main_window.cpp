@@ -23,6 +23,13 @@ SOFTWARE.
 */
 #include "wz.h"
 #pragma hdrstop
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 namespace wz {
 
@@ -40,6 +47,7 @@ public:
 DockIcon::DockIcon()
 {
 	type_ = WidgetType::DockIcon;
+	setInputEvents(InputEvents::None);
 	setSize(48, 48);
 }
 
@@ -53,24 +61,124 @@ void DockPreview::draw(Rect clip)
 	renderer_->drawDockPreview(this, clip);
 }
 
-MainWindow::MainWindow(IRenderer *renderer, MainWindowFlags::Enum flags)
+static Update CreateUpdate(UpdateType::Enum type, Widget *widget, int value)
+{
+	Update update;
+	update.type = type;
+	update.widget = widget;
+	update.value = value;
+	update.callback = NULL;
+	update.data = NULL;
+	update.text[0] = 0;
+	return update;
+}
+
+Update Update::labelText(Label *label, const char *text)
+{
+	WZ_ASSERT(label);
+	Update update = CreateUpdate(UpdateType::LabelText, label, 0);
+
+	if (text)
+	{
+		strncpy(update.text, text, MaxTextLength);
+		update.text[MaxTextLength] = 0;
+	}
+
+	return update;
+}
+
+Update Update::listNumItems(List *list, int nItems)
+{
+	WZ_ASSERT(list);
+	return CreateUpdate(UpdateType::ListNumItems, list, nItems);
+}
+
+Update Update::listSelectedItem(List *list, int selectedItem)
+{
+	WZ_ASSERT(list);
+	return CreateUpdate(UpdateType::ListSelectedItem, list, selectedItem);
+}
+
+Update Update::scrollerValue(Scroller *scroller, int value)
+{
+	WZ_ASSERT(scroller);
+	return CreateUpdate(UpdateType::ScrollerValue, scroller, value);
+}
+
+Update Update::spinnerValue(Spinner *spinner, int value)
+{
+	WZ_ASSERT(spinner);
+	return CreateUpdate(UpdateType::SpinnerValue, spinner, value);
+}
+
+Update Update::buttonSet(Button *button, bool value)
+{
+	WZ_ASSERT(button);
+	return CreateUpdate(UpdateType::ButtonSet, button, value ? 1 : 0);
+}
+
+Update Update::widgetVisible(Widget *widget, bool visible)
+{
+	WZ_ASSERT(widget);
+	return CreateUpdate(UpdateType::WidgetVisible, widget, visible ? 1 : 0);
+}
+
+Update Update::call(UpdateCallback callback, Widget *widget, void *data)
+{
+	WZ_ASSERT(callback);
+	Update update = CreateUpdate(UpdateType::Callback, widget, 0);
+	update.callback = callback;
+	update.data = data;
+	return update;
+}
+
+// Its address is different on each thread, so it identifies the current thread without a platform API.
+static WZ_THREAD_LOCAL char threadMarker;
+
+MainWindow::MainWindow(IRenderer *renderer, MainWindowFlags::Enum flags, IAllocator *allocator)
 {
 	type_ = WidgetType::MainWindow;
+	setInputEvents(InputEvents::None);
+	updateDepth_ = 0;
+	ownerThread_ = &threadMarker;
+	allocator_ = NULL;
+	pool_ = NULL;
+	allocationCheckCallback_ = NULL;
+	allocationCheckData_ = NULL;
+
+	if (allocator)
+	{
+		setAllocator(allocator);
+	}
+
+	updateQueueHead_ = updateQueueTail_ = 0;
+	setUpdateQueueCapacity(256);
+	layoutTimeBudget_ = 0;
+	layoutDeadline_ = 0;
+	layoutBudgetCheckCountdown_ = 0;
+	nIdWidgets_ = 0;
 	cursor_ = Cursor::Default;
 	isShiftKeyDown_ = isControlKeyDown_ = false;
 	lockInputWindow_ = NULL;
+
+	// Pressed buttons, open combos and menus, dragged windows etc. push onto this. Reserved so the first push doesn't allocate during input handling.
+	lockInputWidgetStack_.reserve(8);
+	pressedMouseButtons_ = 0;
+
 	keyboardFocusWidget_ = NULL;
 	movingWindow_ = NULL;
 	windowDockPosition_ = DockPosition::None;
 	ignoreDockTabBarChangedEvent_ = false;
 	menuBar_ = NULL;
 	renderer_ = renderer;
-	flags_ = flags | MainWindowFlags::AnyWidgetMeasureDirty | MainWindowFlags::AnyWidgetRectDirty;
+	flags_ = flags | MainWindowFlags::AnyWidgetMeasureDirty | MainWindowFlags::AnyWidgetRectDirty | MainWindowFlags::LayoutOrderDirty | MainWindowFlags::HitIndexDirty;
+	hitColumns_ = hitRows_ = 0;
 	mainWindow_ = this;
 	isTextCursorVisible_ = true;
 
 	// Create content widget.
 	content_ = new Widget;
+	content_->setInputEvents(InputEvents::None);
 	content_->mainWindow_ = this;
 	addChildWidget(content_);
 
@@ -87,6 +195,7 @@ MainWindow::MainWindow(IRenderer *renderer, MainWindowFlags::Enum flags)
 
 		// Create dock preview widget.
 		dockPreview_ = new DockPreview;
+		dockPreview_->setInputEvents(InputEvents::None);
 		dockPreview_->setDrawManually(true);
 		dockPreview_->setVisible(false);
 		addChildWidget(dockPreview_);
@@ -110,6 +219,26 @@ MainWindow::MainWindow(IRenderer *renderer, MainWindowFlags::Enum flags)
 	}
 }
 
+MainWindow::~MainWindow()
+{
+	WZ_ASSERT(isOwnerThread());
+
+	// Delete the whole hierarchy. Widget destructors don't touch their children, so the order doesn't matter.
+	std::vector<Widget *> widgets(children_.begin(), children_.end());
+	children_.clear();
+
+	while (!widgets.empty())
+	{
+		Widget *widget = widgets.back();
+		widgets.pop_back();
+		widgets.insert(widgets.end(), widget->children_.begin(), widget->children_.end());
+		delete widget;
+	}
+
+	// Take the pool off the thread's pool stack and release it. The main window's own event handlers are freed after this, so the pool may be destroyed then.
+	setAllocator(NULL);
+}
+
 bool MainWindow::isDockingEnabled() const
 {
 	return (flags_ & MainWindowFlags::DockingEnabled) == MainWindowFlags::DockingEnabled;
@@ -142,13 +271,39 @@ bool MainWindow::isControlKeyDown() const
 	return isControlKeyDown_;
 }
 
+static int MouseButtonBit(int mouseButton)
+{
+	return mouseButton >= 0 && mouseButton < 31 ? 1 << mouseButton : 0;
+}
+
+// A widget is only shown if it and all of its ancestors are visible.
+static bool IsShown(const Widget *widget)
+{
+	for (; widget; widget = widget->getParent())
+	{
+		if (!widget->isVisible())
+			return false;
+	}
+
+	return true;
+}
+
 void MainWindow::mouseButtonDown(int mouseButton, int mouseX, int mouseY)
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	doMeasureAndLayoutPasses();
 
 	// Clear keyboard focus widget.
 	keyboardFocusWidget_ = NULL;
 
+	// A new press with no buttons held starts a new capture. Drops widgets left captured by a missed release.
+	if (pressedMouseButtons_ == 0)
+	{
+		releaseCapture();
+	}
+
+	pressedMouseButtons_ |= MouseButtonBit(mouseButton);
 	lockInputWindow_ = getHoverWindow(mouseX, mouseY);
 	Widget *widget = this;
 
@@ -163,7 +318,17 @@ void MainWindow::mouseButtonDown(int mouseButton, int mouseX, int mouseY)
 		widget = lockInputWindow_;
 	}
 
-	mouseButtonDownRecursive(widget, mouseButton, mouseX, mouseY);
+	if (collectHoverPath(widget, InputEvents::MouseButtonDown | InputEvents::MouseButtonUp, &hoverPath_))
+	{
+		for (size_t i = 0; i < hoverPath_.size(); i++)
+		{
+			pressWidget(hoverPath_[i], mouseButton, mouseX, mouseY);
+		}
+	}
+	else
+	{
+		mouseButtonDownRecursive(widget, mouseButton, mouseX, mouseY);
+	}
 
 	// Need a special case for dock icons.
 	updateDockPreviewVisible(mouseX, mouseY);
@@ -171,6 +336,8 @@ void MainWindow::mouseButtonDown(int mouseButton, int mouseX, int mouseY)
 
 void MainWindow::mouseButtonUp(int mouseButton, int mouseX, int mouseY)
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	doMeasureAndLayoutPasses();
 
 	// Need a special case for dock icons.
@@ -186,23 +353,30 @@ void MainWindow::mouseButtonUp(int mouseButton, int mouseX, int mouseY)
 		movingWindow_ = NULL;
 	}
 
-	Widget *widget = this;
+	pressedMouseButtons_ &= ~MouseButtonBit(mouseButton);
 
-	if (!lockInputWidgetStack_.empty())
+	// Route the release to the widgets that received the press. Entries are set to NULL if a widget is removed by a callback.
+	for (size_t i = 0; i < captureWidgets_.size(); i++)
 	{
-		// Lock input to the top/last item on the stack.
-		widget = lockInputWidgetStack_.back();
+		Widget *widget = captureWidgets_[i];
+
+		// A window or tab page may have been hidden since the press.
+		if (widget && IsShown(widget))
+		{
+			widget->onMouseButtonUp(mouseButton, mouseX, mouseY);
+		}
 	}
-	else if (lockInputWindow_)
+
+	if (pressedMouseButtons_ == 0)
 	{
-		widget = lockInputWindow_;
+		releaseCapture();
 	}
-
-	mouseButtonUpRecursive(widget, mouseButton, mouseX, mouseY);
 }
 
 void MainWindow::mouseMove(int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY)
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	doMeasureAndLayoutPasses();
 
 	// Reset the mouse cursor to default.
@@ -214,20 +388,20 @@ void MainWindow::mouseMove(int mouseX, int mouseY, int mouseDeltaX, int mouseDel
 	if (!lockInputWidgetStack_.empty())
 	{
 		// Lock input to the top/last item on the stack.
-		mouseMoveRecursive(NULL, lockInputWidgetStack_.back(), mouseX, mouseY, mouseDeltaX, mouseDeltaY);
+		mouseMoveHitPath(lockInputWidgetStack_.back(), NULL, mouseX, mouseY, mouseDeltaX, mouseDeltaY);
 		return;
 	}
 
 	lockInputWindow_ = getHoverWindow(mouseX, mouseY);
 
-	// Clear hover on everything but the lockInputWindow and it's children.
-	clearHoverRecursive(lockInputWindow_, this);
-
-	mouseMoveRecursive(lockInputWindow_, this, mouseX, mouseY, mouseDeltaX, mouseDeltaY);
+	// Hover on everything but the lockInputWindow and it's children is cleared.
+	mouseMoveHitPath(this, lockInputWindow_, mouseX, mouseY, mouseDeltaX, mouseDeltaY);
 }
 
 void MainWindow::mouseWheelMove(int x, int y)
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	doMeasureAndLayoutPasses();
 
 	Widget *widget = this;
@@ -242,7 +416,17 @@ void MainWindow::mouseWheelMove(int x, int y)
 		widget = lockInputWindow_;
 	}
 
-	mouseWheelMoveRecursive(widget, x, y);
+	if (collectHoverPath(widget, InputEvents::MouseWheelMove, &hoverPath_))
+	{
+		for (size_t i = 0; i < hoverPath_.size(); i++)
+		{
+			hoverPath_[i]->onMouseWheelMove(x, y);
+		}
+	}
+	else
+	{
+		mouseWheelMoveRecursive(widget, x, y);
+	}
 }
 
 void MainWindow::keyDelta(Key::Enum key, bool down)
@@ -254,11 +438,11 @@ void MainWindow::keyDelta(Key::Enum key, bool down)
 	if (!widget || !widget->isVisible())
 		return;
 
-	if (down)
+	if (down && (widget->inputEvents_ & InputEvents::KeyDown))
 	{
 		widget->onKeyDown(key);
 	}
-	else if (!down)
+	else if (!down && (widget->inputEvents_ & InputEvents::KeyUp))
 	{
 		widget->onKeyUp(key);
 	}
@@ -266,6 +450,8 @@ void MainWindow::keyDelta(Key::Enum key, bool down)
 
 void MainWindow::keyDown(Key::Enum key)
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	if (WZ_KEY_MOD_OFF(key) == Key::Unknown)
 		return;
 
@@ -285,6 +471,8 @@ void MainWindow::keyDown(Key::Enum key)
 
 void MainWindow::keyUp(Key::Enum key)
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	if (WZ_KEY_MOD_OFF(key) == Key::Unknown)
 		return;
 
@@ -304,9 +492,11 @@ void MainWindow::keyUp(Key::Enum key)
 
 void MainWindow::textInput(const char *text)
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	Widget *widget = keyboardFocusWidget_;
 
-	if (!widget || !widget->isVisible())
+	if (!widget || !widget->isVisible() || !(widget->inputEvents_ & InputEvents::TextInput))
 		return;
 
 	doMeasureAndLayoutPasses();
@@ -357,6 +547,14 @@ static bool IsWidgetNotWindowOrCombo(const Widget *widget)
 
 void MainWindow::draw()
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
+
+	if (allocator_)
+	{
+		allocator_->beginFrame();
+	}
+
 	doMeasureAndLayoutPasses();
 
 	// Draw the main window (not really) and ancestors. Don't recurse into windows or combos.
@@ -383,7 +581,7 @@ void MainWindow::draw()
 	{
 		Widget *widget = windows[i];
 
-		if (!widget->isVisible())
+		if (!widget->isVisible() || isWidgetLayoutHidden(widget))
 			continue;
 
 		widget->draw(rect_);
@@ -408,6 +606,8 @@ void MainWindow::draw()
 
 void MainWindow::drawFrame()
 {
+	WZ_ASSERT(isOwnerThread());
+	AllocationCheck::Scope allocationCheck(allocationCheckCallback_, allocationCheckData_);
 	renderer_->beginFrame(rect_.w, rect_.h);
 	draw();
 	renderer_->endFrame();
@@ -471,11 +671,61 @@ const Widget *MainWindow::getKeyboardFocusWidget() const
 	return keyboardFocusWidget_;
 }
 
+void MainWindow::setAllocationCheck(AllocationCheckCallback callback, void *data)
+{
+	allocationCheckCallback_ = callback;
+	allocationCheckData_ = data;
+}
+
+void MainWindow::setAllocator(IAllocator *allocator)
+{
+	WZ_ASSERT(isOwnerThread());
+	allocator_ = allocator;
+
+	if (pool_)
+	{
+		// Another main window may have pushed its pool since, so this one isn't necessarily on top. Blocks still allocated from the old pool are freed back to it, and it is destroyed when the last one is.
+		Pool::remove(pool_);
+		Pool::release(pool_);
+		pool_ = NULL;
+	}
+
+	if (allocator)
+	{
+		pool_ = Pool::create(allocator);
+		Pool::push(pool_);
+	}
+}
+
+IAllocator *MainWindow::getAllocator() const
+{
+	return allocator_;
+}
+
 void MainWindow::setKeyboardFocusWidget(Widget *widget)
 {
 	keyboardFocusWidget_ = widget;
 }
 
+MemoryStats MainWindow::getMemoryStats() const
+{
+	MemoryStats stats;
+	std::vector<const Widget *> widgets;
+	widgets.push_back(this);
+
+	while (!widgets.empty())
+	{
+		const Widget *widget = widgets.back();
+		widgets.pop_back();
+		widgets.insert(widgets.end(), widget->children_.begin(), widget->children_.end());
+		widget->addMemoryStats(&stats);
+	}
+
+	stats.strings += FontFaces::getMemoryUsage();
+	stats.rendererCaches = renderer_->getMemoryUsage();
+	return stats;
+}
+
 DockPosition::Enum MainWindow::getWindowDockPosition(const Window *window) const
 {
 	WZ_ASSERT(window);
@@ -504,7 +754,7 @@ void MainWindow::dockWindow(Window *window, DockPosition::Enum dockPosition)
 		return;
 
 	// Do a layout pass so this mainwindow and the window rects are up to date.
-	doMeasureAndLayoutPasses();
+	finishLayout();
 
 	// Not valid, use undockWindow to undock.
 	if (dockPosition == DockPosition::None)
@@ -739,241 +989,1503 @@ void MainWindow::setAnyWidgetRectDirty(bool value)
 
 void MainWindow::onRectChanged()
 {
+	// The hit index grid covers the main window.
+	flags_ = flags_ | MainWindowFlags::HitIndexDirty;
+
 	updateDockIconPositions();
 	updateDockingRects();
 	updateContentRect();
 }
 
-void MainWindow::doMeasureAndLayoutPasses()
+void MainWindow::addMemoryStats(MemoryStats *stats) const
 {
-	if (flags_ & MainWindowFlags::AnyWidgetMeasureDirty)
-	{
-		debugPrintf("***** BEGIN MEASURE PASS *****");
-		doMeasurePassRecursive(isMeasureDirty());
-		setAnyWidgetMeasureDirty(false);
-		debugPrintf("***** END MEASURE PASS *****");
-	}
+	Widget::addMemoryStats(stats);
+	size_t size = sizeof(MainWindow) - sizeof(Widget);
+	size += idBuckets_.capacity() * sizeof(Widget *);
+	size += pendingDirtyWidgets_.capacity() * sizeof(Widget *);
+	size += layoutWidgets_.capacity() * sizeof(Widget *);
+	size += layoutParents_.capacity() * sizeof(int);
+	size += layoutSubtreeEnds_.capacity() * sizeof(int);
+	size += layoutSubtreeInputEvents_.capacity() * sizeof(InputEvents::Enum);
+	size += layoutChildrenDirty_.capacity() / 8;
+	size += measureWidgets_.capacity() * sizeof(Widget *);
+	size += hitCells_.capacity() * sizeof(std::vector<int>);
+
+	for (size_t i = 0; i < hitCells_.size(); i++)
+	{
+		size += hitCells_[i].capacity() * sizeof(int);
+	}
+
+	size += hitRects_.capacity() * sizeof(Rect);
+	size += hitIndices_.capacity() * sizeof(int);
+	size += hitOverlapCounts_.capacity() * sizeof(int);
+	size += hitHoverStates_.capacity() * sizeof(uint8_t);
+	size += hoverWidgets_.capacity() * sizeof(Widget *);
+	size += hoverPath_.capacity() * sizeof(Widget *);
+	size += captureWidgets_.capacity() * sizeof(Widget *);
+	size += lockInputWidgetStack_.capacity() * sizeof(Widget *);
+	size += updateQueue_.capacity() * sizeof(UpdateQueueCell);
+	size += postedUpdates_.capacity() * sizeof(Update);
+	size += keptUpdates_.capacity() * sizeof(int);
+	size += updateCoalesceTable_.capacity() * sizeof(const Update *);
+	size += boundWidgets_.capacity() * sizeof(Widget *);
 
-	if (flags_ & MainWindowFlags::AnyWidgetRectDirty)
+	for (int i = 0; i < DockPosition::NumDockPositions; i++)
 	{
-		debugPrintf("***** BEGIN LAYOUT PASS *****");
-		doLayoutPassRecursive(isRectDirty());
-		setAnyWidgetRectDirty(false);
-		debugPrintf("***** END LAYOUT PASS *****");
+		size += dockedWindows_[i].capacity() * sizeof(Window *);
 	}
+
+	stats->widgets += size;
 }
 
-void MainWindow::mouseButtonDownRecursive(Widget *widget, int mouseButton, int mouseX, int mouseY)
+// FNV-1a
+static uint32_t HashWidgetId(const std::string &id)
 {
-	WZ_ASSERT(widget);
-
-	if (!widget->isVisible())
-		return;
-
-	widget->onMouseButtonDown(mouseButton, mouseX, mouseY);
+	uint32_t hash = 2166136261u;
 
-	for (size_t i = 0; i < widget->children_.size(); i++)
+	for (size_t i = 0; i < id.length(); i++)
 	{
-		if (widget->children_[i]->getHover())
-		{
-			mouseButtonDownRecursive(widget->children_[i], mouseButton, mouseX, mouseY);
-		}
+		hash ^= (uint8_t)id[i];
+		hash *= 16777619u;
 	}
+
+	return hash;
 }
 
-void MainWindow::mouseButtonUpRecursive(Widget *widget, int mouseButton, int mouseX, int mouseY)
+Widget *MainWindow::find(const std::string &id)
 {
-	WZ_ASSERT(widget);
-
-	if (!widget->isVisible())
-		return;
+	if (id.empty() || idBuckets_.empty())
+		return NULL;
 
-	widget->onMouseButtonUp(mouseButton, mouseX, mouseY);
+	const uint32_t hash = HashWidgetId(id);
 
-	for (size_t i = 0; i < widget->children_.size(); i++)
+	for (Widget *widget = idBuckets_[hash & (idBuckets_.size() - 1)]; widget; widget = widget->nextInIdBucket_)
 	{
-		mouseButtonUpRecursive(widget->children_[i], mouseButton, mouseX, mouseY);
+		if (widget->idHash_ == hash && widget->id_ == id)
+			return widget;
 	}
+
+	return NULL;
 }
 
-void MainWindow::clearHoverRecursive(Window *ignoreWindow, Widget *widget)
+void MainWindow::findMany(const std::vector<std::string> &ids, std::vector<Widget *> *results)
 {
-	WZ_ASSERT(widget);
-
-	if (widget == ignoreWindow)
-		return;
-
-	if (widget->getHover())
-	{
-		// Stop hovering.
-		widget->hover_ = false;
-		widget->onMouseHoverOff();
-	}
+	WZ_ASSERT(results);
+	results->resize(ids.size());
 
-	for (size_t i = 0; i < widget->children_.size(); i++)
+	for (size_t i = 0; i < ids.size(); i++)
 	{
-		clearHoverRecursive(ignoreWindow, widget->children_[i]);
+		(*results)[i] = find(ids[i]);
 	}
 }
 
-void MainWindow::ignoreOverlappingChildren(Widget *widget, int mouseX, int mouseY)
+void MainWindow::registerWidgetId(Widget *widget)
 {
 	WZ_ASSERT(widget);
+	WZ_ASSERT(!widget->id_.empty());
 
-	for (size_t i = 0; i < widget->children_.size(); i++)
+	// Keep the load factor at or below 1.
+	if (nIdWidgets_ + 1 > idBuckets_.size())
 	{
-		widget->children_[i]->ignore_ = false;
-	}
+		std::vector<Widget *> oldBuckets;
+		oldBuckets.swap(idBuckets_);
+		idBuckets_.resize(WZ_MAX(oldBuckets.size() * 2, (size_t)64), NULL);
 
-	for (size_t i = 0; i < widget->children_.size(); i++)
-	{
-		for (size_t j = 0; j < widget->children_.size(); j++)
+		for (size_t i = 0; i < oldBuckets.size(); i++)
 		{
-			Rect rect1, rect2, intersection;
+			Widget *next;
 
-			if (i == j)
-				continue;
-
-			if (!widget->children_[j]->isVisible())
-				continue;
-
-			// If the mouse cursor is in the intersection of the two widget rects.
-			rect1 = widget->children_[i]->getAbsoluteRect();
-			rect2 = widget->children_[j]->getAbsoluteRect();
-
-			if (Rect::intersect(rect1, rect2, &intersection) && WZ_POINT_IN_RECT(mouseX, mouseY, intersection))
+			for (Widget *w = oldBuckets[i]; w; w = next)
 			{
-				// Ignore the one that isn't set to overlap.
-				if (widget->children_[i]->overlap_)
-				{
-					widget->children_[j]->ignore_ = true;
-				}
-				else if (widget->children_[j]->overlap_)
-				{
-					widget->children_[i]->ignore_ = true;
-				}
+				next = w->nextInIdBucket_;
+				Widget *&bucket = idBuckets_[w->idHash_ & (idBuckets_.size() - 1)];
+				w->nextInIdBucket_ = bucket;
+				bucket = w;
 			}
 		}
 	}
+
+	widget->idHash_ = HashWidgetId(widget->id_);
+	Widget *&bucket = idBuckets_[widget->idHash_ & (idBuckets_.size() - 1)];
+	widget->nextInIdBucket_ = bucket;
+	bucket = widget;
+	nIdWidgets_++;
 }
 
-void MainWindow::mouseMoveRecursive(Window *window, Widget *widget, int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY)
+void MainWindow::unregisterWidgetId(Widget *widget)
 {
-	Rect rect;
-	bool hoverWindow;
-	bool hoverParent;
-	bool widgetIsChildOfWindow;
-	bool oldHover;
-
 	WZ_ASSERT(widget);
 
-	if (!widget->isVisible())
+	if (idBuckets_.empty())
 		return;
 
-	// Don't process mouse move if the widget is ignored.
-	if (widget->ignore_)
+	for (Widget **link = &idBuckets_[widget->idHash_ & (idBuckets_.size() - 1)]; *link; link = &(*link)->nextInIdBucket_)
 	{
-		if (widget->getHover())
+		if (*link == widget)
 		{
-			// Stop hovering.
-			widget->hover_ = false;
-			widget->onMouseHoverOff();
+			*link = widget->nextInIdBucket_;
+			widget->nextInIdBucket_ = NULL;
+			nIdWidgets_--;
+			return;
 		}
-
-		return;
 	}
+}
 
-	// Determine whether the mouse is hovering over the widget's parent window.
-	// Special case for combo dropdown list poking outside the window.
-	if (widget->window_ && widget->findClosestAncestor(WidgetType::Combo) == NULL)
-	{
-		hoverWindow = WZ_POINT_IN_RECT(mouseX, mouseY, widget->window_->getContentWidget()->getAbsoluteRect());
-	}
-	else
-	{
-		hoverWindow = true;
-	}
+void MainWindow::registerBoundWidget(Widget *widget)
+{
+	WZ_ASSERT(widget);
+	boundWidgets_.push_back(widget);
+}
 
-	// Determine whether the mouse is hovering over the widget's parent.
-	if (widget->inputClippedToParent_ && widget->parent_ && widget->parent_ != this && widget->parent_ != widget->window_)
-	{
-		hoverParent = WZ_POINT_IN_RECT(mouseX, mouseY, widget->parent_->getAbsoluteRect());
-	}
-	else
+void MainWindow::unregisterBoundWidget(Widget *widget)
+{
+	WZ_ASSERT(widget);
+
+	for (size_t i = 0; i < boundWidgets_.size(); i++)
 	{
-		hoverParent = true;
+		if (boundWidgets_[i] == widget)
+		{
+			boundWidgets_[i] = boundWidgets_.back();
+			boundWidgets_.pop_back();
+			return;
+		}
 	}
+}
 
-	// Or the window itself.
-	widgetIsChildOfWindow = !window || (window && (widget->window_ == window || widget == window));
-
-	// Set widget hover.
-	oldHover = widget->getHover();
-	rect = widget->getAbsoluteRect();
-	widget->hover_ = widgetIsChildOfWindow && hoverWindow && hoverParent && WZ_POINT_IN_RECT(mouseX, mouseY, rect);
+void MainWindow::unregisterHoverWidget(Widget *widget)
+{
+	WZ_ASSERT(widget);
+	widget->setFlag(WidgetFlags::Hover, false);
 
-	// Run callbacks if hover has changed.
-	if (!oldHover && widget->getHover())
-	{
-		widget->onMouseHoverOn();
-	}
-	else if (oldHover && !widget->getHover())
+	for (size_t i = 0; i < hoverWidgets_.size(); i++)
 	{
-		widget->onMouseHoverOff();
+		if (hoverWidgets_[i] == widget)
+		{
+			hoverWidgets_.erase(hoverWidgets_.begin() + i);
+			return;
+		}
 	}
+}
 
-	// Run mouse move if the mouse is hovering over the widget, or if input is locked to the widget.
-	if (widget->getHover() || (widgetIsChildOfWindow && !lockInputWidgetStack_.empty() && widget == lockInputWidgetStack_.back()))
-	{
-		widget->onMouseMove(mouseX, mouseY, mouseDeltaX, mouseDeltaY);
-	}
+void MainWindow::transferCapture(Widget *from, Widget *to)
+{
+	WZ_ASSERT(from);
+	WZ_ASSERT(to);
 
-	ignoreOverlappingChildren(widget, mouseX, mouseY);
+	if (from == to || to->hasFlag(WidgetFlags::Captured))
+		return;
 
-	for (size_t i = 0; i < widget->children_.size(); i++)
+	to->setFlag(WidgetFlags::Captured, true);
+
+	if (from->hasFlag(WidgetFlags::Captured))
 	{
-		mouseMoveRecursive(window, widget->children_[i], mouseX, mouseY, mouseDeltaX, mouseDeltaY);
+		from->setFlag(WidgetFlags::Captured, false);
+
+		for (size_t i = 0; i < captureWidgets_.size(); i++)
+		{
+			if (captureWidgets_[i] == from)
+			{
+				captureWidgets_[i] = to;
+				return;
+			}
+		}
 	}
+
+	captureWidgets_.push_back(to);
 }
 
-void MainWindow::mouseWheelMoveRecursive(Widget *widget, int x, int y)
+void MainWindow::unregisterCaptureWidget(Widget *widget)
 {
 	WZ_ASSERT(widget);
+	widget->setFlag(WidgetFlags::Captured, false);
 
-	if (!widget->isVisible())
-		return;
-
-	widget->onMouseWheelMove(x, y);
-
-	for (size_t i = 0; i < widget->children_.size(); i++)
+	// Don't erase, mouseButtonUp may be iterating.
+	for (size_t i = 0; i < captureWidgets_.size(); i++)
 	{
-		if (widget->children_[i]->getHover())
+		if (captureWidgets_[i] == widget)
 		{
-			mouseWheelMoveRecursive(widget->children_[i], x, y);
+			captureWidgets_[i] = NULL;
 		}
 	}
 }
 
-void MainWindow::drawWidgetRecursive(Widget *widget, Rect clip, WidgetPredicate drawPredicate, WidgetPredicate recursePredicate)
+void MainWindow::refreshBindings()
 {
-	bool drawLastFound = false;
-
-	if (!widget->isVisible())
+	if (boundWidgets_.empty())
 		return;
 
-	// Don't render the widget if it's outside its parent window.
-	// Special case for combo ancestors.
-	if (!widget->overlapsParentWindow() && !IsWidgetComboAncestor(widget))
-		return;
+	// Only widgets whose bound value has changed are touched, and their dirty flags are propagated once at the end.
+	beginUpdate();
 
-	if (drawPredicate(widget) && !widget->drawManually_)
+	// A refresh may fire events that bind or unbind widgets. Walk backwards, so unregisterBoundWidget's swap-remove can never move a widget that hasn't been refreshed yet past the cursor. Widgets bound during the walk are refreshed next frame.
+	for (size_t i = boundWidgets_.size(); i-- > 0;)
 	{
-		widget->draw(clip);
+		if (i < boundWidgets_.size())
+		{
+			boundWidgets_[i]->refreshBinding();
+		}
 	}
 
-	// Update clip rect.
-	if (!Rect::intersect(clip, widget->getChildrenClipRect(), &clip))
-	{
+	endUpdate();
+}
+
+void MainWindow::setLayoutTimeBudget(int milliseconds)
+{
+	layoutTimeBudget_ = WZ_MAX(0, milliseconds);
+}
+
+int MainWindow::getLayoutTimeBudget() const
+{
+	return layoutTimeBudget_;
+}
+
+bool MainWindow::isLayoutComplete() const
+{
+	return (flags_ & (MainWindowFlags::AnyWidgetMeasureDirty | MainWindowFlags::AnyWidgetRectDirty)) == 0;
+}
+
+void MainWindow::finishLayout()
+{
+	const int budget = layoutTimeBudget_;
+	layoutTimeBudget_ = 0;
+	doMeasureAndLayoutPasses();
+	layoutTimeBudget_ = budget;
+}
+
+bool MainWindow::isOwnerThread() const
+{
+	return ownerThread_ == &threadMarker;
+}
+
+void MainWindow::beginUpdate()
+{
+	WZ_ASSERT(isOwnerThread());
+	updateDepth_++;
+}
+
+void MainWindow::endUpdate()
+{
+	WZ_ASSERT(updateDepth_ > 0);
+
+	if (updateDepth_ > 1)
+	{
+		updateDepth_--;
+		return;
+	}
+
+	// Propagate the dirty flags now that the update scope has ended. Each widget is only in the list once.
+	// Still updating while doing this, so parent layouts dirtied by propagation are added to the end of the list instead of propagating immediately. That way a parent shared by many dirty widgets is only handled once.
+	for (size_t i = 0; i < pendingDirtyWidgets_.size(); i++)
+	{
+		Widget *widget = pendingDirtyWidgets_[i];
+		const int pending = widget->flags_ & (WidgetFlags::PendingMeasureDirty | WidgetFlags::PendingRectDirty);
+		widget->flags_ = WidgetFlags::Enum(widget->flags_ & ~(WidgetFlags::PendingMeasureDirty | WidgetFlags::PendingRectDirty));
+
+		if (pending & WidgetFlags::PendingMeasureDirty)
+		{
+			widget->propagateMeasureDirty();
+		}
+
+		if (pending & WidgetFlags::PendingRectDirty)
+		{
+			widget->propagateRectDirty();
+		}
+	}
+
+	pendingDirtyWidgets_.clear();
+	updateDepth_ = 0;
+}
+
+bool MainWindow::isUpdating() const
+{
+	return updateDepth_ > 0;
+}
+
+bool MainWindow::post(const Update &update)
+{
+	const unsigned long mask = (unsigned long)updateQueue_.size() - 1;
+	long position = WZ_ATOMIC_LOAD(&updateQueueHead_);
+	UpdateQueueCell *cell;
+
+	// Claim a cell by advancing the head. If another thread claimed it first, try again with the new head.
+	for (;;)
+	{
+		cell = &updateQueue_[(unsigned long)position & mask];
+		const long sequence = WZ_ATOMIC_LOAD(&cell->sequence);
+		const long difference = (long)((unsigned long)sequence - (unsigned long)position);
+
+		if (difference == 0)
+		{
+			const long oldPosition = WZ_ATOMIC_COMPARE_EXCHANGE(&updateQueueHead_, position, (long)((unsigned long)position + 1));
+
+			if (oldPosition == position)
+				break;
+
+			position = oldPosition;
+		}
+		else if (difference < 0)
+		{
+			// The cell hasn't been applied since the last time around, the queue is full.
+			return false;
+		}
+		else
+		{
+			position = WZ_ATOMIC_LOAD(&updateQueueHead_);
+		}
+	}
+
+	cell->update = update;
+
+	// Publish to the main window's thread.
+	WZ_ATOMIC_STORE(&cell->sequence, (long)((unsigned long)position + 1));
+	return true;
+}
+
+void MainWindow::setUpdateQueueCapacity(int capacity)
+{
+	size_t size = 1;
+
+	while ((int)size < capacity)
+	{
+		size *= 2;
+	}
+
+	// Apply anything pending so it isn't lost.
+	if (!updateQueue_.empty())
+	{
+		applyPostedUpdates();
+	}
+
+	updateQueue_.resize(size);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		updateQueue_[i].sequence = (long)i;
+	}
+
+	updateQueueHead_ = updateQueueTail_ = 0;
+	postedUpdates_.reserve(size);
+	keptUpdates_.reserve(size);
+	updateCoalesceTable_.resize(size * 2);
+}
+
+int MainWindow::getUpdateQueueCapacity() const
+{
+	return (int)updateQueue_.size();
+}
+
+void MainWindow::applyPostedUpdates()
+{
+	// Drain the queue. Cells are freed as they're read, so stop after one queue's worth: a thread that keeps posting can't hold this thread here, and the batch fits in postedUpdates_ and the coalesce table. Anything left is applied next time.
+	const unsigned long mask = (unsigned long)updateQueue_.size() - 1;
+	postedUpdates_.clear();
+
+	for (size_t n = 0; n < updateQueue_.size(); n++)
+	{
+		UpdateQueueCell &cell = updateQueue_[(unsigned long)updateQueueTail_ & mask];
+		const long next = (long)((unsigned long)updateQueueTail_ + 1);
+
+		if (WZ_ATOMIC_LOAD(&cell.sequence) != next)
+			break;
+
+		postedUpdates_.push_back(cell.update);
+
+		// The cell can be posted to again the next time around.
+		WZ_ATOMIC_STORE(&cell.sequence, (long)((unsigned long)updateQueueTail_ + mask + 1));
+		updateQueueTail_ = next;
+	}
+
+	if (postedUpdates_.empty())
+		return;
+
+	// Coalesce: walk backwards so the last update to each widget and property is the one kept. The table is an open addressing hash set, at most half full.
+	const size_t tableMask = updateCoalesceTable_.size() - 1;
+	updateCoalesceTable_.assign(updateCoalesceTable_.size(), (const Update *)NULL);
+	keptUpdates_.clear();
+
+	for (int i = (int)postedUpdates_.size() - 1; i >= 0; i--)
+	{
+		const Update &update = postedUpdates_[i];
+
+		if (update.type != UpdateType::Callback)
+		{
+			size_t slot = (((size_t)update.widget >> 4) * 31 + update.type) & tableMask;
+			bool superseded = false;
+
+			while (updateCoalesceTable_[slot])
+			{
+				const Update *other = updateCoalesceTable_[slot];
+
+				if (other->widget == update.widget && other->type == update.type)
+				{
+					superseded = true;
+					break;
+				}
+
+				slot = (slot + 1) & tableMask;
+			}
+
+			if (superseded)
+				continue;
+
+			updateCoalesceTable_[slot] = &update;
+		}
+
+		keptUpdates_.push_back(i);
+	}
+
+	// Apply in the order they were posted. The dirty flags of all the updated widgets are propagated once at the end.
+	beginUpdate();
+
+	for (int i = (int)keptUpdates_.size() - 1; i >= 0; i--)
+	{
+		applyUpdate(postedUpdates_[keptUpdates_[i]]);
+	}
+
+	endUpdate();
+}
+
+void MainWindow::applyUpdate(const Update &update)
+{
+	switch (update.type)
+	{
+	case UpdateType::LabelText:
+		{
+			Label *label = (Label *)update.widget;
+
+			// Label::setText always re-measures.
+			if (strcmp(label->getText(), update.text) != 0)
+			{
+				label->setText(update.text);
+			}
+		}
+		break;
+	case UpdateType::ListNumItems:
+		if (((List *)update.widget)->getNumItems() != update.value)
+		{
+			((List *)update.widget)->setNumItems(update.value);
+		}
+		break;
+	case UpdateType::ListSelectedItem:
+		((List *)update.widget)->setSelectedItem(update.value);
+		break;
+	case UpdateType::ScrollerValue:
+		((Scroller *)update.widget)->setValue(update.value);
+		break;
+	case UpdateType::SpinnerValue:
+		if (((Spinner *)update.widget)->getValue() != update.value)
+		{
+			((Spinner *)update.widget)->setValue(update.value);
+		}
+		break;
+	case UpdateType::ButtonSet:
+		((Button *)update.widget)->set(update.value != 0);
+		break;
+	case UpdateType::WidgetVisible:
+		update.widget->setVisible(update.value != 0);
+		break;
+	case UpdateType::Callback:
+		update.callback(update.widget, update.data);
+		break;
+	}
+}
+
+void MainWindow::addPendingDirtyWidget(Widget *widget)
+{
+	WZ_ASSERT(widget);
+	pendingDirtyWidgets_.push_back(widget);
+}
+
+void MainWindow::purgePendingDirtyWidgets()
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < pendingDirtyWidgets_.size(); i++)
+	{
+		Widget *widget = pendingDirtyWidgets_[i];
+
+		if (widget->mainWindow_ == this)
+		{
+			pendingDirtyWidgets_[n++] = widget;
+		}
+		else
+		{
+			// Detached from the hierarchy. The dirty flags are already set, adding it to a parent again will propagate them.
+			widget->flags_ = WidgetFlags::Enum(widget->flags_ & ~(WidgetFlags::PendingMeasureDirty | WidgetFlags::PendingRectDirty));
+		}
+	}
+
+	pendingDirtyWidgets_.resize(n);
+}
+
+void MainWindow::setLayoutOrderDirty(bool value)
+{
+	if (value)
+	{
+		flags_ = flags_ | MainWindowFlags::LayoutOrderDirty;
+	}
+	else
+	{
+		flags_ = MainWindowFlags::Enum(flags_ & ~MainWindowFlags::LayoutOrderDirty);
+	}
+}
+
+// Monotonic wall clock time. Not clock(), which is CPU time summed over every thread in the process on POSIX, so it runs ahead when other threads are busy.
+static uint64_t GetMicroseconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000 + (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000 + (uint64_t)time.tv_nsec / 1000;
+#endif
+}
+
+void MainWindow::doMeasureAndLayoutPasses()
+{
+	WZ_ASSERT(isOwnerThread());
+	applyPostedUpdates();
+	refreshBindings();
+
+	if (layoutTimeBudget_ > 0)
+	{
+		layoutDeadline_ = GetMicroseconds() + (uint64_t)layoutTimeBudget_ * 1000;
+		layoutBudgetCheckCountdown_ = 0;
+	}
+
+	if (flags_ & MainWindowFlags::AnyWidgetMeasureDirty)
+	{
+		debugPrintf("***** BEGIN MEASURE PASS *****");
+		setAnyWidgetMeasureDirty(false);
+		const bool measured = doMeasurePass();
+		debugPrintf("***** END MEASURE PASS *****");
+
+		// Out of time. Laying out with stale measurements would only have to be redone, so leave the previous rects until measuring is finished.
+		if (!measured)
+			return;
+	}
+
+	if (flags_ & MainWindowFlags::AnyWidgetRectDirty)
+	{
+		debugPrintf("***** BEGIN LAYOUT PASS *****");
+		setAnyWidgetRectDirty(false);
+		doLayoutPass();
+		debugPrintf("***** END LAYOUT PASS *****");
+	}
+}
+
+bool MainWindow::isLayoutTimeBudgetExceeded()
+{
+	if (layoutTimeBudget_ == 0)
+		return false;
+
+	// Reading the clock for every widget would be a significant part of the cost of the passes.
+	if (layoutBudgetCheckCountdown_ > 0)
+	{
+		layoutBudgetCheckCountdown_--;
+		return false;
+	}
+
+	layoutBudgetCheckCountdown_ = 64;
+	return GetMicroseconds() >= layoutDeadline_;
+}
+
+void MainWindow::refreshLayoutOrder()
+{
+	if ((flags_ & MainWindowFlags::LayoutOrderDirty) == 0)
+		return;
+
+	layoutWidgets_.clear();
+	layoutParents_.clear();
+	layoutSubtreeEnds_.clear();
+
+	// Pre-order traversal with an explicit stack of layout order indices. Each entry is pushed when visited, and popped once all of its children have been visited.
+	std::vector<int> stack;
+	std::vector<size_t> nextChild;
+	layoutWidgets_.push_back(this);
+	layoutIndex_ = 0;
+	layoutParents_.push_back(-1);
+	layoutSubtreeEnds_.push_back(0);
+	stack.push_back(0);
+	nextChild.push_back(0);
+
+	while (!stack.empty())
+	{
+		const int index = stack.back();
+		const Widget *widget = layoutWidgets_[index];
+
+		if (nextChild.back() == widget->children_.size())
+		{
+			layoutSubtreeEnds_[index] = (int)layoutWidgets_.size();
+			stack.pop_back();
+			nextChild.pop_back();
+			continue;
+		}
+
+		Widget *child = widget->children_[nextChild.back()];
+		nextChild.back()++;
+		child->layoutIndex_ = (int)layoutWidgets_.size();
+		stack.push_back((int)layoutWidgets_.size());
+		nextChild.push_back(0);
+		layoutWidgets_.push_back(child);
+		layoutParents_.push_back(index);
+		layoutSubtreeEnds_.push_back(0);
+	}
+
+	// Children come after their parents, so going backwards each widget's subtree is complete before it's added to its parent's.
+	layoutSubtreeInputEvents_.resize(layoutWidgets_.size());
+
+	for (size_t i = 0; i < layoutWidgets_.size(); i++)
+	{
+		layoutSubtreeInputEvents_[i] = layoutWidgets_[i]->inputEvents_;
+	}
+
+	for (size_t i = layoutWidgets_.size() - 1; i > 0; i--)
+	{
+		const int parent = layoutParents_[i];
+		layoutSubtreeInputEvents_[parent] = layoutSubtreeInputEvents_[parent] | layoutSubtreeInputEvents_[i];
+	}
+
+	layoutChildrenDirty_.resize(layoutWidgets_.size());
+	setLayoutOrderDirty(false);
+	flags_ = flags_ | MainWindowFlags::HitIndexDirty;
+}
+
+bool MainWindow::doMeasurePass()
+{
+	refreshLayoutOrder();
+
+	// Gather the widgets that need re-measuring, skipping clean subtrees.
+	measureWidgets_.clear();
+	const int n = (int)layoutWidgets_.size();
+
+	for (int i = 0; i < n;)
+	{
+		Widget *widget = layoutWidgets_[i];
+
+		// Skip clean subtrees. Hidden subtrees keep their flags, Widget::setVisible picks them up again when shown.
+		if (!widget->isVisible() || (widget->flags_ & (WidgetFlags::MeasureDirty | WidgetFlags::DescendantMeasureDirty)) == 0)
+		{
+			i = layoutSubtreeEnds_[i];
+			continue;
+		}
+
+		widget->flags_ = WidgetFlags::Enum(widget->flags_ & ~WidgetFlags::DescendantMeasureDirty);
+
+		if (widget->isMeasureDirty())
+		{
+			measureWidgets_.push_back(widget);
+		}
+
+		i++;
+	}
+
+	// Descendants come after their ancestors in layout order, so measure in reverse.
+	for (int i = (int)measureWidgets_.size() - 1; i >= 0; i--)
+	{
+		Widget *widget = measureWidgets_[i];
+
+		// Clear the flag first, so a widget that reads its own measured size while measuring gets the previous size instead of measuring itself again, see Widget::getMeasuredSize.
+		widget->setMeasureDirty(false);
+		widget->measuredSize_ = widget->measure();
+
+		// Always measure at least one widget, so a slow gather above can't stop the pass from making progress.
+		if (i > 0 && isLayoutTimeBudgetExceeded())
+		{
+			// The widgets that haven't been measured are still flagged MeasureDirty, but their ancestors had DescendantMeasureDirty cleared above.
+			for (int j = 0; j < i; j++)
+			{
+				measureWidgets_[j]->setAncestorsFlag(WidgetFlags::DescendantMeasureDirty);
+			}
+
+			setAnyWidgetMeasureDirty();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MainWindow::doLayoutPass()
+{
+	refreshLayoutOrder();
+	const int n = (int)layoutWidgets_.size();
+
+	for (int i = 0; i < n;)
+	{
+		Widget *widget = layoutWidgets_[i];
+		const int parent = layoutParents_[i];
+		const bool dirty = parent != -1 && layoutChildrenDirty_[parent];
+
+		// Skip hidden subtrees. If the parent has changed, flag the widget so it is laid out when shown, see Widget::setVisible.
+		if (!widget->isVisible())
+		{
+			if (dirty)
+			{
+				widget->flags_ = widget->flags_ | WidgetFlags::RectDirty;
+			}
+
+			layoutChildrenDirty_[i] = false;
+			i = layoutSubtreeEnds_[i];
+			continue;
+		}
+
+		// Skip clean subtrees.
+		if (!dirty && (widget->flags_ & (WidgetFlags::RectDirty | WidgetFlags::DescendantRectDirty | WidgetFlags::ChildrenRectDirty)) == 0)
+		{
+			layoutChildrenDirty_[i] = false;
+			i = layoutSubtreeEnds_[i];
+			continue;
+		}
+
+		layoutChildrenDirty_[i] = widget->doLayoutPass(dirty);
+		i++;
+
+		// A widget was added or removed during the pass, so the layout order is stale. Flag the widgets whose children haven't been repositioned yet and finish on the next pass.
+		if (flags_ & MainWindowFlags::LayoutOrderDirty)
+		{
+			for (int j = 0; j < i; j++)
+			{
+				if (layoutChildrenDirty_[j])
+				{
+					layoutWidgets_[j]->flags_ = layoutWidgets_[j]->flags_ | WidgetFlags::ChildrenRectDirty;
+					layoutWidgets_[j]->setAncestorsFlag(WidgetFlags::DescendantRectDirty);
+				}
+			}
+
+			setAnyWidgetRectDirty();
+			break;
+		}
+
+		// Out of time. Pick up from here on the next pass.
+		if (i < n && isLayoutTimeBudgetExceeded())
+		{
+			deferLayout(i);
+			break;
+		}
+	}
+}
+
+void MainWindow::deferLayout(int stop)
+{
+	// The widgets not laid out yet are the children of the last widget laid out, and the later siblings of it and its ancestors. Those whose parent rect changed need flagging, the rest keep their own flags.
+	// The layout pass cleared DescendantRectDirty on the ancestors, so set it again or the next pass would skip them.
+	int next = stop;
+
+	for (int i = stop - 1; i != -1; i = layoutParents_[i])
+	{
+		layoutWidgets_[i]->flags_ = layoutWidgets_[i]->flags_ | WidgetFlags::DescendantRectDirty;
+
+		if (layoutChildrenDirty_[i])
+		{
+			for (int j = next; j < layoutSubtreeEnds_[i]; j = layoutSubtreeEnds_[j])
+			{
+				layoutWidgets_[j]->markRectDirty();
+			}
+		}
+
+		next = layoutSubtreeEnds_[i];
+	}
+
+	setAnyWidgetRectDirty();
+}
+
+static const int hitCellSize = 64;
+
+// Get the range of hit index cells that overlap rect. Returns false if there are none.
+static bool GetHitCellRange(Rect rect, int columns, int rows, int *x1, int *y1, int *x2, int *y2)
+{
+	if (rect.w <= 0 || rect.h <= 0)
+		return false;
+
+	if (rect.x + rect.w <= 0 || rect.y + rect.h <= 0 || rect.x >= columns * hitCellSize || rect.y >= rows * hitCellSize)
+		return false;
+
+	*x1 = WZ_MAX(rect.x, 0) / hitCellSize;
+	*y1 = WZ_MAX(rect.y, 0) / hitCellSize;
+	*x2 = WZ_MIN(rect.x + rect.w - 1, columns * hitCellSize - 1) / hitCellSize;
+	*y2 = WZ_MIN(rect.y + rect.h - 1, rows * hitCellSize - 1) / hitCellSize;
+	return true;
+}
+
+void MainWindow::updateHitRect(Widget *widget)
+{
+	WZ_ASSERT(widget);
+
+	// Wait for the full rebuild.
+	if (flags_ & (MainWindowFlags::LayoutOrderDirty | MainWindowFlags::HitIndexDirty))
+		return;
+
+	const int index = widget->layoutIndex_;
+
+	if (index < 0 || index >= (int)hitRects_.size() || layoutWidgets_[index] != widget)
+		return;
+
+	const Rect rect = widget->getAbsoluteRect();
+	removeHitRect(index, hitRects_[index]);
+	addHitRect(index, rect);
+	hitRects_[index] = rect;
+}
+
+void MainWindow::refreshHitIndex()
+{
+	if (!(flags_ & MainWindowFlags::HitIndexDirty))
+		return;
+
+	hitColumns_ = WZ_MAX(1, (rect_.w + hitCellSize - 1) / hitCellSize);
+	hitRows_ = WZ_MAX(1, (rect_.h + hitCellSize - 1) / hitCellSize);
+	const size_t nCells = size_t(hitColumns_ * hitRows_);
+
+	// Keep the cell capacity around, it's rebuilt whenever the layout order changes.
+	if (hitCells_.size() < nCells)
+	{
+		hitCells_.resize(nCells);
+	}
+
+	for (size_t i = 0; i < hitCells_.size(); i++)
+	{
+		hitCells_[i].clear();
+	}
+
+	hitRects_.resize(layoutWidgets_.size());
+	hitOverlapCounts_.assign(layoutWidgets_.size() * 2, 0);
+
+	for (size_t i = 0; i < layoutWidgets_.size(); i++)
+	{
+		hitRects_[i] = layoutWidgets_[i]->getAbsoluteRect();
+		addHitRect((int)i, hitRects_[i]);
+	}
+
+	flags_ = MainWindowFlags::Enum(flags_ & ~MainWindowFlags::HitIndexDirty);
+}
+
+void MainWindow::addHitRect(int index, Rect rect)
+{
+	int x1, y1, x2, y2;
+
+	if (!GetHitCellRange(rect, hitColumns_, hitRows_, &x1, &y1, &x2, &y2))
+		return;
+
+	for (int y = y1; y <= y2; y++)
+	{
+		for (int x = x1; x <= x2; x++)
+		{
+			hitCells_[y * hitColumns_ + x].push_back(index);
+		}
+	}
+}
+
+void MainWindow::removeHitRect(int index, Rect rect)
+{
+	int x1, y1, x2, y2;
+
+	if (!GetHitCellRange(rect, hitColumns_, hitRows_, &x1, &y1, &x2, &y2))
+		return;
+
+	for (int y = y1; y <= y2; y++)
+	{
+		for (int x = x1; x <= x2; x++)
+		{
+			std::vector<int> &cell = hitCells_[y * hitColumns_ + x];
+
+			for (size_t i = 0; i < cell.size(); i++)
+			{
+				if (cell[i] == index)
+				{
+					cell[i] = cell.back();
+					cell.pop_back();
+					break;
+				}
+			}
+		}
+	}
+}
+
+void MainWindow::hitTest(int x, int y, std::vector<int> *indices)
+{
+	WZ_ASSERT(indices);
+	WZ_ASSERT(!(flags_ & MainWindowFlags::LayoutOrderDirty));
+	refreshHitIndex();
+	indices->clear();
+
+	if (x >= 0 && y >= 0 && x < hitColumns_ * hitCellSize && y < hitRows_ * hitCellSize)
+	{
+		const std::vector<int> &cell = hitCells_[(y / hitCellSize) * hitColumns_ + x / hitCellSize];
+
+		for (size_t i = 0; i < cell.size(); i++)
+		{
+			if (WZ_POINT_IN_RECT(x, y, hitRects_[cell[i]]))
+			{
+				indices->push_back(cell[i]);
+			}
+		}
+	}
+	else
+	{
+		// Outside the grid, only widgets poking outside the main window can be hit.
+		for (size_t i = 0; i < hitRects_.size(); i++)
+		{
+			if (WZ_POINT_IN_RECT(x, y, hitRects_[i]))
+			{
+				indices->push_back((int)i);
+			}
+		}
+	}
+
+	// Sort into layout order. Cells are mostly in order already, since they are filled in layout order.
+	for (size_t i = 1; i < indices->size(); i++)
+	{
+		const int index = (*indices)[i];
+		size_t j = i;
+
+		while (j > 0 && (*indices)[j - 1] > index)
+		{
+			(*indices)[j] = (*indices)[j - 1];
+			j--;
+		}
+
+		(*indices)[j] = index;
+	}
+}
+
+void MainWindow::mouseButtonDownRecursive(Widget *widget, int mouseButton, int mouseX, int mouseY)
+{
+	WZ_ASSERT(widget);
+
+	if (!widget->isVisible())
+		return;
+
+	pressWidget(widget, mouseButton, mouseX, mouseY);
+
+	for (size_t i = 0; i < widget->children_.size(); i++)
+	{
+		if (widget->children_[i]->getHover())
+		{
+			mouseButtonDownRecursive(widget->children_[i], mouseButton, mouseX, mouseY);
+		}
+	}
+}
+
+void MainWindow::pressWidget(Widget *widget, int mouseButton, int mouseX, int mouseY)
+{
+	WZ_ASSERT(widget);
+
+	// Capture the pointer, so the widget gets the release wherever it happens.
+	if ((widget->inputEvents_ & InputEvents::MouseButtonUp) && !widget->hasFlag(WidgetFlags::Captured))
+	{
+		widget->setFlag(WidgetFlags::Captured, true);
+		captureWidgets_.push_back(widget);
+	}
+
+	if (widget->inputEvents_ & InputEvents::MouseButtonDown)
+	{
+		widget->onMouseButtonDown(mouseButton, mouseX, mouseY);
+	}
+}
+
+void MainWindow::releaseCapture()
+{
+	for (size_t i = 0; i < captureWidgets_.size(); i++)
+	{
+		if (captureWidgets_[i])
+		{
+			captureWidgets_[i]->setFlag(WidgetFlags::Captured, false);
+		}
+	}
+
+	captureWidgets_.clear();
+}
+
+bool MainWindow::collectHoverPath(Widget *root, InputEvents::Enum events, std::vector<Widget *> *widgets)
+{
+	WZ_ASSERT(root);
+	WZ_ASSERT(widgets);
+	widgets->clear();
+
+	if (!isInLayoutOrder(root))
+		return false;
+
+	// Nothing in the subtree can react.
+	if (!root->isVisible() || !(layoutSubtreeInputEvents_[root->layoutIndex_] & events))
+		return true;
+
+	if (root->inputEvents_ & events)
+	{
+		widgets->push_back(root);
+	}
+
+	const int first = root->layoutIndex_;
+	const int end = layoutSubtreeEnds_[first];
+
+	for (size_t i = 0; i < hoverWidgets_.size(); i++)
+	{
+		Widget *widget = hoverWidgets_[i];
+
+		if (!(widget->inputEvents_ & events) || widget->layoutIndex_ <= first || widget->layoutIndex_ >= end || !widget->isVisible())
+			continue;
+
+		// Every ancestor up to root must be visible and hovering too.
+		bool onPath = true;
+
+		for (Widget *ancestor = widget->parent_; ancestor != root; ancestor = ancestor->parent_)
+		{
+			if (!ancestor->isVisible() || !ancestor->getHover())
+			{
+				onPath = false;
+				break;
+			}
+		}
+
+		if (!onPath)
+			continue;
+
+		// Insert in layout order.
+		size_t j = widgets->size();
+
+		while (j > 0 && (*widgets)[j - 1]->layoutIndex_ > widget->layoutIndex_)
+		{
+			j--;
+		}
+
+		widgets->insert(widgets->begin() + j, widget);
+	}
+
+	return true;
+}
+
+bool MainWindow::isInLayoutOrder(const Widget *widget) const
+{
+	WZ_ASSERT(widget);
+
+	if (flags_ & MainWindowFlags::LayoutOrderDirty)
+		return false;
+
+	return widget->layoutIndex_ >= 0 && widget->layoutIndex_ < (int)layoutWidgets_.size() && layoutWidgets_[widget->layoutIndex_] == widget;
+}
+
+bool MainWindow::subtreeHandlesInputEvents(const Widget *widget, InputEvents::Enum events) const
+{
+	if (!isInLayoutOrder(widget))
+		return true;
+
+	return (layoutSubtreeInputEvents_[widget->layoutIndex_] & events) != 0;
+}
+
+bool MainWindow::isChildOfWindow(const Window *window, const Widget *widget) const
+{
+	WZ_ASSERT(widget);
+	return !window || widget == window || widget->window_ == window;
+}
+
+void MainWindow::clearHover(Window *ignoreWindow)
+{
+	size_t i = 0;
+
+	// Widgets are removed from hoverWidgets_ as they stop hovering.
+	while (i < hoverWidgets_.size())
+	{
+		Widget *widget = hoverWidgets_[i];
+
+		if (ignoreWindow && isChildOfWindow(ignoreWindow, widget))
+		{
+			i++;
+		}
+		else
+		{
+			setWidgetHover(widget, false);
+		}
+	}
+}
+
+void MainWindow::setWidgetHover(Widget *widget, bool hover)
+{
+	WZ_ASSERT(widget);
+
+	if (widget->getHover() == hover)
+		return;
+
+	if (hover)
+	{
+		widget->setFlag(WidgetFlags::Hover, true);
+		hoverWidgets_.push_back(widget);
+
+		if (widget->inputEvents_ & InputEvents::MouseHover)
+		{
+			widget->onMouseHoverOn();
+		}
+	}
+	else
+	{
+		unregisterHoverWidget(widget);
+
+		if (widget->inputEvents_ & InputEvents::MouseHover)
+		{
+			widget->onMouseHoverOff();
+		}
+	}
+}
+
+// A widget containing the mouse cursor is ignored if a sibling that also contains the cursor is set to overlap, and either the widget is visible or isn't set to overlap itself.
+static bool IsOverlapped(bool overlap, bool visible, int nOverlap, int nVisibleOverlap)
+{
+	// Don't count the widget itself.
+	if (overlap)
+	{
+		nOverlap--;
+
+		if (visible)
+			nVisibleOverlap--;
+	}
+
+	return (visible && nOverlap > 0) || (!overlap && nVisibleOverlap > 0);
+}
+
+void MainWindow::ignoreOverlappingChildren(Widget *widget, int mouseX, int mouseY)
+{
+	WZ_ASSERT(widget);
+	int nOverlap = 0, nVisibleOverlap = 0;
+
+	for (size_t i = 0; i < widget->children_.size(); i++)
+	{
+		Widget *child = widget->children_[i];
+		child->setFlag(WidgetFlags::Ignore, false);
+
+		if (child->hasFlag(WidgetFlags::Overlap) && WZ_POINT_IN_RECT(mouseX, mouseY, child->getAbsoluteRect()))
+		{
+			nOverlap++;
+
+			if (child->isVisible())
+				nVisibleOverlap++;
+		}
+	}
+
+	if (nOverlap == 0)
+		return;
+
+	for (size_t i = 0; i < widget->children_.size(); i++)
+	{
+		Widget *child = widget->children_[i];
+
+		if (WZ_POINT_IN_RECT(mouseX, mouseY, child->getAbsoluteRect()) && IsOverlapped(child->hasFlag(WidgetFlags::Overlap), child->isVisible(), nOverlap, nVisibleOverlap))
+		{
+			child->setFlag(WidgetFlags::Ignore, true);
+		}
+	}
+}
+
+void MainWindow::ignoreOverlappingHitIndices(int root, int mouseX, int mouseY)
+{
+	// Count the siblings under the cursor that are set to overlap, per parent. Every widget under the cursor is in hitIndices_, so there's no need to look at the rest of the children.
+	for (size_t i = 0; i < hitIndices_.size(); i++)
+	{
+		const int index = hitIndices_[i];
+		const int parent = layoutParents_[index];
+		const Widget *widget = layoutWidgets_[index];
+
+		if (index != root && widget->hasFlag(WidgetFlags::Overlap) && WZ_POINT_IN_RECT(mouseX, mouseY, hitRects_[index]))
+		{
+			hitOverlapCounts_[parent * 2]++;
+
+			if (widget->isVisible())
+				hitOverlapCounts_[parent * 2 + 1]++;
+		}
+	}
+
+	for (size_t i = 0; i < hitIndices_.size(); i++)
+	{
+		const int index = hitIndices_[i];
+		const int parent = layoutParents_[index];
+		Widget *widget = layoutWidgets_[index];
+		bool ignore = false;
+
+		// Root's siblings aren't candidates, so leave its flag alone.
+		if (index == root)
+			continue;
+
+		if (hitOverlapCounts_[parent * 2] > 0 && WZ_POINT_IN_RECT(mouseX, mouseY, hitRects_[index]))
+		{
+			ignore = IsOverlapped(widget->hasFlag(WidgetFlags::Overlap), widget->isVisible(), hitOverlapCounts_[parent * 2], hitOverlapCounts_[parent * 2 + 1]);
+		}
+
+		widget->setFlag(WidgetFlags::Ignore, ignore);
+	}
+
+	// Reset the counts that were used.
+	for (size_t i = 0; i < hitIndices_.size(); i++)
+	{
+		const int parent = layoutParents_[hitIndices_[i]];
+
+		if (hitIndices_[i] != root)
+		{
+			hitOverlapCounts_[parent * 2] = hitOverlapCounts_[parent * 2 + 1] = 0;
+		}
+	}
+}
+
+void MainWindow::mouseMoveRecursive(Window *window, Widget *widget, int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY)
+{
+	WZ_ASSERT(widget);
+
+	if (!mouseMoveWidget(window, widget, mouseX, mouseY, mouseDeltaX, mouseDeltaY))
+		return;
+
+	ignoreOverlappingChildren(widget, mouseX, mouseY);
+
+	for (size_t i = 0; i < widget->children_.size(); i++)
+	{
+		mouseMoveRecursive(window, widget->children_[i], mouseX, mouseY, mouseDeltaX, mouseDeltaY);
+	}
+}
+
+void MainWindow::mouseMoveHitPath(Widget *root, Window *window, int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY)
+{
+	WZ_ASSERT(root);
+
+	// The hit index can't be used if a widget has been added or removed since the layout order was built.
+	if (!isInLayoutOrder(root))
+	{
+		if (root == this)
+		{
+			clearHover(window);
+		}
+
+		mouseMoveRecursive(window, root, mouseX, mouseY, mouseDeltaX, mouseDeltaY);
+		return;
+	}
+
+	// Same as mouseMoveWidget returning false.
+	if (!root->isVisible())
+		return;
+
+	if (root->hasFlag(WidgetFlags::Ignore))
+	{
+		setWidgetHover(root, false);
+		return;
+	}
+
+	// Only the widgets under the cursor can start hovering or get onMouseMove, and only the widgets that are hovering can stop. Widgets outside root are left alone.
+	const int first = root->layoutIndex_;
+	const int end = layoutSubtreeEnds_[first];
+	hitTest(mouseX, mouseY, &hitIndices_);
+
+	if (root != this)
+	{
+		size_t n = 0;
+
+		for (size_t i = 0; i < hitIndices_.size(); i++)
+		{
+			if (hitIndices_[i] >= first && hitIndices_[i] < end)
+			{
+				hitIndices_[n++] = hitIndices_[i];
+			}
+		}
+
+		hitIndices_.resize(n);
+	}
+
+	// Root gets onMouseMove if input is locked to it, even when it isn't under the cursor.
+	if (hitIndices_.empty() || hitIndices_[0] != first)
+	{
+		hitIndices_.insert(hitIndices_.begin(), first);
+	}
+
+	for (size_t i = 0; i < hoverWidgets_.size(); i++)
+	{
+		const int index = hoverWidgets_[i]->layoutIndex_;
+		WZ_ASSERT(layoutWidgets_[index] == hoverWidgets_[i]);
+
+		if (index < first || index >= end)
+			continue;
+
+		// Insert in layout order, if it isn't already under the cursor.
+		size_t j = hitIndices_.size();
+
+		while (j > 0 && hitIndices_[j - 1] > index)
+		{
+			j--;
+		}
+
+		if (j == 0 || hitIndices_[j - 1] != index)
+		{
+			hitIndices_.insert(hitIndices_.begin() + j, index);
+		}
+	}
+
+	// mouseMoveRecursive sets the ignore flags on a widget's children when visiting it. Children that don't contain the cursor can't be ignored, so only the candidates need flags.
+	ignoreOverlappingHitIndices(first, mouseX, mouseY);
+
+	// Work out the new hover state of every candidate before running any callbacks.
+	hitHoverStates_.resize(hitIndices_.size());
+
+	for (size_t i = 0; i < hitIndices_.size(); i++)
+	{
+		const int index = hitIndices_[i];
+		const Widget *widget = layoutWidgets_[index];
+		bool hover = widget->isVisible() && !widget->hasFlag(WidgetFlags::Ignore) && calculateWidgetHover(window, widget, mouseX, mouseY);
+
+		// Not hovering if mouseMoveRecursive wouldn't reach the widget from root: an ancestor is hidden, or is ignored.
+		for (int j = layoutParents_[index]; hover && j > first; j = layoutParents_[j])
+		{
+			const Widget *ancestor = layoutWidgets_[j];
+
+			if (!ancestor->isVisible() || (ancestor->hasFlag(WidgetFlags::Ignore) && WZ_POINT_IN_RECT(mouseX, mouseY, hitRects_[j])))
+			{
+				hover = false;
+			}
+		}
+
+		hitHoverStates_[i] = hover ? 1 : 0;
+	}
+
+	// Only widgets that have left or entered the hover path get callbacks. Stop hovering first, so at no point are the old and new widgets both hovering.
+	for (size_t i = 0; i < hitIndices_.size(); i++)
+	{
+		if (!hitHoverStates_[i])
+		{
+			setWidgetHover(layoutWidgets_[hitIndices_[i]], false);
+
+			// A callback added or removed a widget, so the layout order indices are stale.
+			if (flags_ & MainWindowFlags::LayoutOrderDirty)
+				return;
+		}
+	}
+
+	for (size_t i = 0; i < hitIndices_.size(); i++)
+	{
+		if (hitHoverStates_[i])
+		{
+			setWidgetHover(layoutWidgets_[hitIndices_[i]], true);
+
+			if (flags_ & MainWindowFlags::LayoutOrderDirty)
+				return;
+		}
+	}
+
+	// Run mouse move on the hovered widgets, and the widget input is locked to, in layout order like mouseMoveRecursive.
+	if (!(layoutSubtreeInputEvents_[first] & InputEvents::MouseMove))
+		return;
+
+	for (size_t i = 0; i < hitIndices_.size(); i++)
+	{
+		Widget *widget = layoutWidgets_[hitIndices_[i]];
+
+		if (!(widget->inputEvents_ & InputEvents::MouseMove))
+			continue;
+
+		if ((hitHoverStates_[i] && widget->getHover()) || (isChildOfWindow(window, widget) && !lockInputWidgetStack_.empty() && widget == lockInputWidgetStack_.back()))
+		{
+			widget->onMouseMove(mouseX, mouseY, mouseDeltaX, mouseDeltaY);
+
+			if (flags_ & MainWindowFlags::LayoutOrderDirty)
+				return;
+		}
+	}
+}
+
+bool MainWindow::calculateWidgetHover(Window *window, const Widget *widget, int mouseX, int mouseY) const
+{
+	bool hoverWindow;
+	bool hoverParent;
+
+	WZ_ASSERT(widget);
+
+	// Determine whether the mouse is hovering over the widget's parent window.
+	// Special case for combo dropdown list poking outside the window.
+	if (widget->window_ && widget->findClosestAncestor(WidgetType::Combo) == NULL)
+	{
+		hoverWindow = WZ_POINT_IN_RECT(mouseX, mouseY, widget->window_->getContentWidget()->getAbsoluteRect());
+	}
+	else
+	{
+		hoverWindow = true;
+	}
+
+	// Determine whether the mouse is hovering over the widget's parent.
+	if (widget->hasFlag(WidgetFlags::InputClippedToParent) && widget->parent_ && widget->parent_ != this && widget->parent_ != widget->window_)
+	{
+		hoverParent = WZ_POINT_IN_RECT(mouseX, mouseY, widget->parent_->getAbsoluteRect());
+	}
+	else
+	{
+		hoverParent = true;
+	}
+
+	return isChildOfWindow(window, widget) && hoverWindow && hoverParent && WZ_POINT_IN_RECT(mouseX, mouseY, widget->getAbsoluteRect());
+}
+
+bool MainWindow::mouseMoveWidget(Window *window, Widget *widget, int mouseX, int mouseY, int mouseDeltaX, int mouseDeltaY)
+{
+	WZ_ASSERT(widget);
+
+	if (!widget->isVisible())
+		return false;
+
+	// Don't process mouse move if the widget is ignored.
+	if (widget->hasFlag(WidgetFlags::Ignore))
+	{
+		setWidgetHover(widget, false);
+		return false;
+	}
+
+	setWidgetHover(widget, calculateWidgetHover(window, widget, mouseX, mouseY));
+
+	// Run mouse move if the mouse is hovering over the widget, or if input is locked to the widget.
+	if (!(widget->inputEvents_ & InputEvents::MouseMove))
+		return true;
+
+	if (widget->getHover() || (isChildOfWindow(window, widget) && !lockInputWidgetStack_.empty() && widget == lockInputWidgetStack_.back()))
+	{
+		widget->onMouseMove(mouseX, mouseY, mouseDeltaX, mouseDeltaY);
+	}
+
+	return true;
+}
+
+void MainWindow::mouseWheelMoveRecursive(Widget *widget, int x, int y)
+{
+	WZ_ASSERT(widget);
+
+	if (!widget->isVisible())
+		return;
+
+	if (widget->inputEvents_ & InputEvents::MouseWheelMove)
+	{
+		widget->onMouseWheelMove(x, y);
+	}
+
+	for (size_t i = 0; i < widget->children_.size(); i++)
+	{
+		if (widget->children_[i]->getHover())
+		{
+			mouseWheelMoveRecursive(widget->children_[i], x, y);
+		}
+	}
+}
+
+void MainWindow::drawWidgetRecursive(Widget *widget, Rect clip, WidgetPredicate drawPredicate, WidgetPredicate recursePredicate)
+{
+	bool drawLastFound = false;
+
+	if (!widget->isVisible() || isWidgetLayoutHidden(widget))
+		return;
+
+	// Don't render the widget if it's outside its parent window.
+	// Special case for combo ancestors.
+	if (!widget->overlapsParentWindow() && !IsWidgetComboAncestor(widget))
+		return;
+
+	if (drawPredicate(widget) && !widget->hasFlag(WidgetFlags::DrawManually))
+	{
+		widget->draw(clip);
+	}
+
+	// Update clip rect.
+	if (!Rect::intersect(clip, widget->getChildrenClipRect(), &clip))
+	{
 		// Reset to main window clip rect.
 		clip = rect_;
 	}
@@ -1007,6 +2519,11 @@ void MainWindow::drawWidgetRecursive(Widget *widget, Rect clip, WidgetPredicate
 	}
 }
 
+bool MainWindow::isWidgetLayoutHidden(const Widget *widget) const
+{
+	return (flags_ & MainWindowFlags::HideIncompleteLayout) && widget->isRectDirty();
+}
+
 void MainWindow::drawWidget(Widget *widget, WidgetPredicate drawPredicate, WidgetPredicate recursePredicate)
 {
 	WZ_ASSERT(widget);
@@ -1019,13 +2536,33 @@ Window *MainWindow::getHoverWindow(int mouseX, int mouseY)
 	bool resultIsDocked = false;
 	int drawPriority = -1;
 
-	for (size_t i = 0; i < children_.size(); i++)
+	// Use the hit index to find the windows under the cursor, unless the layout order is stale. The candidates are in layout order, which matches children_ order.
+	const bool useHitIndex = (flags_ & MainWindowFlags::LayoutOrderDirty) == 0;
+
+	if (useHitIndex)
+	{
+		hitTest(mouseX, mouseY, &hitIndices_);
+	}
+
+	const size_t n = useHitIndex ? hitIndices_.size() : children_.size();
+
+	for (size_t i = 0; i < n; i++)
 	{
 		Widget *widget;
 		Window *window;
 		bool docked;
 
-		widget = children_[i];
+		if (useHitIndex)
+		{
+			if (layoutParents_[hitIndices_[i]] != 0)
+				continue;
+
+			widget = layoutWidgets_[hitIndices_[i]];
+		}
+		else
+		{
+			widget = children_[i];
+		}
 
 		if (widget->getType() != WidgetType::Window)
 			continue;
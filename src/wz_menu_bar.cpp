@@ -37,6 +37,7 @@ MENU BAR BUTTON
 MenuBarButton::MenuBarButton(MenuBar *menuBar)
 {
 	type_ = WidgetType::MenuBarButton;
+	setInputEvents(InputEvents::MouseButtonDown | InputEvents::MouseButtonUp | InputEvents::MouseHover);
 	isPressed_ = isSet_ = false;
 	menuBar_ = menuBar;
 }
@@ -90,6 +91,9 @@ void MenuBarButton::onMouseHoverOn()
 
 		otherButton->isPressed_ = false;
 		isPressed_ = true;
+
+		// This button gets the release now, so it can pop the input lock.
+		mainWindow_->transferCapture(otherButton, this);
 		return;
 	}
 }
@@ -104,6 +108,14 @@ Size MenuBarButton::measure()
 	return renderer_->measureMenuBarButton(this);
 }
 
+void MenuBarButton::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(MenuBarButton) - sizeof(Widget);
+	stats->eventHandlers += pressedCallbacks_.capacity() * sizeof(EventCallback);
+	stats->strings += label_.capacity();
+}
+
 /*
 ================================================================================
 
@@ -115,6 +127,7 @@ MENU BAR
 MenuBar::MenuBar()
 {
 	type_ = WidgetType::MenuBar;
+	setInputEvents(InputEvents::None);
 
 	layout_ = new StackLayout(StackLayoutDirection::Horizontal, 0);
 	layout_->setStretch(Stretch::All);
@@ -144,4 +157,10 @@ Size MenuBar::measure()
 	return renderer_->measureMenuBar(this);
 }
 
+void MenuBar::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(MenuBar) - sizeof(Widget);
+}
+
 } // namespace wz
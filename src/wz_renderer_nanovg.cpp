@@ -39,11 +39,35 @@ struct Image
 	char filename[WZ_NANOVG_MAX_PATH];
 };
 
+// Installed even without an allocator, so AllocationCheck sees NanoVG allocations. NVGmemoryCategory values map onto the AllocationCategory NanoVG values in order.
+static void *NVGReallocate(void *userPtr, void *ptr, size_t size, int category)
+{
+	const AllocationCategory::Enum wzCategory = AllocationCategory::Enum(AllocationCategory::NanoVGContext + category);
+
+	if (size > 0)
+	{
+		AllocationCheck::report(wzCategory, size, NULL);
+	}
+
+	if (userPtr)
+		return ((IAllocator *)userPtr)->reallocate(ptr, size, wzCategory);
+
+	if (size == 0)
+	{
+		free(ptr);
+		return NULL;
+	}
+
+	return realloc(ptr, size);
+}
+
 struct NVGRendererImpl
 {
 	NVGRendererImpl() : destroy(NULL), vg(NULL), nImages(0), defaultFontSize(0)
 	{
 		errorMessage[0] = 0;
+		nvgAllocator.reallocate = NVGReallocate;
+		nvgAllocator.userPtr = NULL;
 	}
 
 	char errorMessage[WZ_NANOVG_MAX_ERROR_MESSAGE];
@@ -53,6 +77,9 @@ struct NVGRendererImpl
 	int nImages;
 	char fontDirectory[WZ_NANOVG_MAX_PATH];
 	float defaultFontSize;
+
+	// Copied by the NanoVG context when it's created.
+	NVGallocator nvgAllocator;
 };
 
 static NVGcolor ConvertColor(Color c)
@@ -60,7 +87,7 @@ static NVGcolor ConvertColor(Color c)
 	return nvgRGBAf(c.r, c.g, c.b, c.a);
 }
 
-NVGRenderer::NVGRenderer(wzNanoVgGlCreate create, wzNanoVgGlDestroy destroy, int flags, const char *fontDirectory, const char *defaultFontFace, float defaultFontSize)
+NVGRenderer::NVGRenderer(wzNanoVgGlCreate create, wzNanoVgGlDestroy destroy, int flags, const char *fontDirectory, const char *defaultFontFace, float defaultFontSize, IAllocator *allocator)
 {
 	WZ_ASSERT(create);
 	WZ_ASSERT(destroy);
@@ -69,8 +96,13 @@ NVGRenderer::NVGRenderer(wzNanoVgGlCreate create, wzNanoVgGlDestroy destroy, int
 	impl->destroy = destroy;
 	impl->defaultFontSize = defaultFontSize;
 
-	// Init nanovg.
+	// Init nanovg. The context and the GL backend pick up the allocator when they're created.
+	const NVGallocator *previousAllocator = nvgGetAllocator();
+
+	impl->nvgAllocator.userPtr = allocator;
+	nvgSetAllocator(&impl->nvgAllocator);
 	impl->vg = create(flags);
+	nvgSetAllocator(previousAllocator);
 
 	if (!impl->vg)
 	{
@@ -402,28 +434,27 @@ void NVGRenderer::drawLabel(Label *label, Rect clip)
 
 Size NVGRenderer::measureLabel(Label *label)
 {
-	NVGcontext *vg = impl->vg;
-	Size size;
-
+	// Wrap to the user width. Layouts that give the label a width measure it with Label::measureConstrained instead.
 	if (label->getMultiline())
-	{
-		nvgFontSize(vg, label->getFontSize() == 0 ? getDefaultFontSize() : label->getFontSize());
-		setFontFace(label->getFontFace());
-		nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
-		nvgTextLineHeight(vg, 1.0f);
-		float bounds[4];
-		nvgTextBoxBounds(vg, 0, 0, (float)label->getUserOrMeasuredSize().w, label->getText(), NULL, bounds);
-		size.w = (int)bounds[2];
-		size.h = (int)bounds[3];
-	}
-	else
-	{
-		label->measureText(label->getText(), 0, &size.w, &size.h);
-	}
+		return measureLabelWrapped(label, label->getUserRect().w);
 
+	Size size;
+	label->measureText(label->getText(), 0, &size.w, &size.h);
 	return size;
 }
 
+Size NVGRenderer::measureLabelWrapped(Label *label, int lineWidth)
+{
+	NVGcontext *vg = impl->vg;
+	nvgFontSize(vg, label->getFontSize() == 0 ? getDefaultFontSize() : label->getFontSize());
+	setFontFace(label->getFontFace());
+	nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+	nvgTextLineHeight(vg, 1.0f);
+	float bounds[4];
+	nvgTextBoxBounds(vg, 0, 0, (float)lineWidth, label->getText(), NULL, bounds);
+	return Size((int)bounds[2], (int)bounds[3]);
+}
+
 void NVGRenderer::drawList(List *list, Rect clip)
 {
 	NVGcontext *vg = impl->vg;
@@ -1048,6 +1079,12 @@ LineBreakResult NVGRenderer::lineBreakText(const char * /*fontFace*/, float /*fo
 	return result;
 }
 
+size_t NVGRenderer::getMemoryUsage() const
+{
+	// The image cache is a fixed size array. NanoVG doesn't expose the size of its font atlas.
+	return sizeof(NVGRendererImpl);
+}
+
 const char *NVGRenderer::getError()
 {
 	return impl->errorMessage[0] == 0 ? NULL : impl->errorMessage;
@@ -23,6 +23,7 @@ SOFTWARE.
 */
 #pragma once
 
+#include <memory>
 #include "wz.h"
 #include <nanovg.h>
 
@@ -144,10 +145,12 @@ typedef void (*wzNanoVgGlDestroy)(NVGcontext* ctx);
 
 struct NVGRendererImpl;
 
+// Each renderer owns its NanoVG context, fonts and images, so use one renderer per main window thread, with that thread's GL context current. Don't share a renderer between threads.
 class NVGRenderer : public IRenderer
 {
 public:
-	NVGRenderer(wzNanoVgGlCreate create, wzNanoVgGlDestroy destroy, int flags, const char *fontDirectory, const char *defaultFontFace, float defaultFontSize);
+	// If allocator is not NULL, the NanoVG context, backend, fonts and images allocate through it. It must outlive the renderer.
+	NVGRenderer(wzNanoVgGlCreate create, wzNanoVgGlDestroy destroy, int flags, const char *fontDirectory, const char *defaultFontFace, float defaultFontSize, IAllocator *allocator = NULL);
 	~NVGRenderer();
 	virtual Color getClearColor();
 	virtual void beginFrame(int windowWidth, int windowHeight);
@@ -166,6 +169,7 @@ public:
 	virtual Color getLabelTextColor(Label *label);
 	virtual void drawLabel(Label *label, Rect clip);
 	virtual Size measureLabel(Label *label);
+	virtual Size measureLabelWrapped(Label *label, int lineWidth);
 	virtual void drawList(List *list, Rect clip);
 	virtual Size measureList(List *list);
 	virtual void drawMenuBarButton(MenuBarButton *button, Rect clip);
@@ -220,6 +224,8 @@ public:
 
 	virtual LineBreakResult lineBreakText(const char *fontFace, float fontSize, const char *text, int n, int lineWidth);
 
+	virtual size_t getMemoryUsage() const;
+
 	const char *getError();
 	NVGcontext *getContext();
 	float getDefaultFontSize() const;
@@ -58,6 +58,11 @@ NUB CONTAINER
 class ScrollerNubContainer : public Widget
 {
 public:
+	ScrollerNubContainer()
+	{
+		setInputEvents(InputEvents::MouseButtonDown);
+	}
+
 	void onRectChanged()
 	{
 		((ScrollerNub *)children_[0])->updateRect();
@@ -92,6 +97,7 @@ SCROLLER NUB WIDGET
 
 ScrollerNub::ScrollerNub(Scroller *scroller)
 {
+	setInputEvents(InputEvents::MouseButtonDown | InputEvents::MouseButtonUp | InputEvents::MouseMove);
 	scroller_ = scroller;
 	isPressed_ = false;
 }
@@ -173,7 +179,7 @@ void ScrollerNub::updateRect()
 
 void ScrollerNub::onMouseButtonDown(int mouseButton, int mouseX, int mouseY)
 {
-	if (mouseButton == 1 && hover_)
+	if (mouseButton == 1 && getHover())
 	{
 		const Rect rect = getAbsoluteRect();
 		isPressed_ = true;
@@ -219,6 +225,12 @@ void ScrollerNub::onMouseMove(int mouseX, int mouseY, int /*mouseDeltaX*/, int /
 	}
 }
 
+void ScrollerNub::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(ScrollerNub) - sizeof(Widget);
+}
+
 /*
 ================================================================================
 
@@ -230,11 +242,14 @@ SCROLLER WIDGET
 Scroller::Scroller(ScrollerDirection::Enum direction, int value, int stepValue, int maxValue)
 {
 	type_ = WidgetType::Scroller;
+	setInputEvents(InputEvents::MouseWheelMove);
 	nubScale_ = 0;
 	direction_ = direction;
 	stepValue_ = WZ_MAX(1, stepValue);
 	maxValue_ = WZ_MAX(0, maxValue);
 	value_ = WZ_CLAMPED(0, value, maxValue_);
+	boundValue_ = NULL;
+	boundGeneration_ = 0;
 
 	StackLayout *layout = new StackLayout(direction_ == ScrollerDirection::Vertical ? StackLayoutDirection::Vertical : StackLayoutDirection::Horizontal);
 	layout->setStretch(Stretch::All);
@@ -278,6 +293,12 @@ void Scroller::setValue(int value)
 	if (oldValue == value_)
 		return;
 
+	if (boundValue_)
+	{
+		boundValue_->set(value_);
+		boundGeneration_ = boundValue_->getGeneration();
+	}
+
 	Event e;
 	e.scroller.type = EventType::ScrollerValueChanged;
 	e.scroller.scroller = this;
@@ -363,6 +384,29 @@ void Scroller::addCallbackValueChanged(EventCallback callback)
 	valueChangedCallbacks_.push_back(callback);
 }
 
+void Scroller::bindValue(Bindable<int> *value)
+{
+	boundValue_ = value;
+	setBound(value != NULL);
+
+	if (value)
+	{
+		boundGeneration_ = value->getGeneration();
+		setValue(value->get());
+	}
+}
+
+void Scroller::refreshBinding()
+{
+	if (boundValue_->getGeneration() == boundGeneration_)
+		return;
+
+	boundGeneration_ = boundValue_->getGeneration();
+
+	// The value may be clamped, in which case the clamped value is copied back.
+	setValue(boundValue_->get());
+}
+
 void Scroller::onRectChanged()
 {
 	// Match the buttons to the scroller thickness, and keep square.
@@ -386,6 +430,13 @@ Size Scroller::measure()
 	return renderer_->measureScroller(this);
 }
 
+void Scroller::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(Scroller) - sizeof(Widget);
+	stats->eventHandlers += valueChangedCallbacks_.capacity() * sizeof(EventCallback);
+}
+
 void Scroller::onDecrementButtonClicked(Event)
 {
 	decrementValue();
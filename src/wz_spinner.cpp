@@ -60,6 +60,7 @@ static bool wz_spinner_validate_text(const char *text)
 Spinner::Spinner()
 {
 	type_ = WidgetType::Spinner;
+	setInputEvents(InputEvents::None);
 
 	textEdit_ = new TextEdit(false);
 	textEdit_->setStretch(Stretch::All);
@@ -81,6 +82,9 @@ Spinner::Spinner()
 	incrementButton_->addEventHandler(EventType::ButtonClicked, this, &Spinner::onIncrementButtonClicked);
 	incrementButton_->setOverlap(true);
 	addChildWidget(incrementButton_);
+
+	boundValue_ = NULL;
+	boundGeneration_ = 0;
 }
 
 int Spinner::getValue() const
@@ -107,6 +111,42 @@ const TextEdit *Spinner::getTextEdit() const
 	return textEdit_;
 }
 
+void Spinner::bindValue(Bindable<int> *value)
+{
+	boundValue_ = value;
+	setBound(value != NULL);
+
+	if (value)
+	{
+		boundGeneration_ = value->getGeneration();
+		setValue(value->get());
+	}
+}
+
+void Spinner::refreshBinding()
+{
+	if (boundValue_->getGeneration() != boundGeneration_)
+	{
+		boundGeneration_ = boundValue_->getGeneration();
+
+		if (getValue() != boundValue_->get())
+		{
+			setValue(boundValue_->get());
+		}
+
+		return;
+	}
+
+	// The value is edited as text by the child text edit, so compare to see if the user changed it.
+	const int value = getValue();
+
+	if (value != boundValue_->get())
+	{
+		boundValue_->set(value);
+		boundGeneration_ = boundValue_->getGeneration();
+	}
+}
+
 void Spinner::onRendererChanged()
 {
 	decrementButton_->setWidth(renderer_->getSpinnerButtonWidth(this));
@@ -134,6 +174,12 @@ Size Spinner::measure()
 	return renderer_->measureSpinner(this);
 }
 
+void Spinner::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(Spinner) - sizeof(Widget);
+}
+
 void Spinner::onDecrementButtonClicked(Event)
 {
 	setValue(getValue() - 1);
@@ -29,6 +29,7 @@ namespace wz {
 StackLayout::StackLayout(StackLayoutDirection::Enum direction, int spacing)
 {
 	type_ = WidgetType::StackLayout;
+	setInputEvents(InputEvents::None);
 	direction_ = direction;
 	spacing_ = spacing;
 }
@@ -60,6 +61,24 @@ void StackLayout::add(Widget *widget)
 	addChildWidget(widget);
 }
 
+void StackLayout::add(const std::vector<Widget *> &widgets)
+{
+	std::vector<Widget *> children;
+	children.reserve(widgets.size());
+
+	for (size_t i = 0; i < widgets.size(); i++)
+	{
+		WZ_ASSERT(widgets[i]);
+
+		if (widgets[i]->getType() == WidgetType::MainWindow || widgets[i]->getType() == WidgetType::Window)
+			continue;
+
+		children.push_back(widgets[i]);
+	}
+
+	addChildWidgets(children);
+}
+
 void StackLayout::remove(Widget *widget)
 {
 	WZ_ASSERT(widget);
@@ -89,7 +108,8 @@ Size StackLayout::measure()
 		if (!child->isVisible())
 			continue;
 
-		const Size childSize = child->getMeasuredSize();
+		// Match the size the child will be given by doLayout.
+		const Size childSize = child->getUserOrMeasuredSize();
 
 		if (direction_ == StackLayoutDirection::Vertical)
 		{
@@ -106,6 +126,12 @@ Size StackLayout::measure()
 	return s + Size(margin_.left + margin_.right, margin_.top + margin_.bottom);
 }
 
+void StackLayout::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(StackLayout) - sizeof(Widget);
+}
+
 void StackLayout::layoutVertical()
 {
 	int availableHeight = rect_.h;
@@ -134,8 +160,9 @@ void StackLayout::layoutVertical()
 		}
 		else
 		{
-			// Subtract the user or measured heights of child widgets that aren't being stretched in the same direction as the the layout.
-			availableHeight -= children_[i]->getUserOrMeasuredSize().h;
+			// Subtract the user or measured heights of child widgets that aren't being stretched in the same direction as the the layout. The measured height may depend on the width.
+			const int childWidth = (children_[i]->getStretch() & Stretch::Width) != 0 ? rect_.w - (children_[i]->getMargin().left + children_[i]->getMargin().right) : children_[i]->getUserOrMeasuredSize().w;
+			availableHeight -= children_[i]->getUserOrMeasuredSize(childWidth, 0).h;
 		}
 	}
 
@@ -189,7 +216,7 @@ void StackLayout::layoutVertical()
 		else
 		{
 			// Use the user or measured height.
-			childRect.h = child->getUserOrMeasuredSize().h;
+			childRect.h = child->getUserOrMeasuredSize(childRect.w, 0).h;
 		}
 
 		child->setRectInternal(childRect);
@@ -270,7 +297,7 @@ void StackLayout::layoutHorizontal()
 		else
 		{
 			// Use the user or measured height.
-			childRect.h = child->getUserOrMeasuredSize().h;
+			childRect.h = child->getUserOrMeasuredSize(childRect.w, 0).h;
 
 			// Handle vertical alignment.
 			if ((child->getAlign() & Align::Middle) != 0)
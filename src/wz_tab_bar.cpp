@@ -75,6 +75,7 @@ TAB BAR
 TabBar::TabBar()
 {
 	type_ = WidgetType::TabBar;
+	setInputEvents(InputEvents::None);
 	selectedTab_ = NULL;
 	scrollValue_ = 0;
 
@@ -238,6 +239,13 @@ Size TabBar::measure()
 	return renderer_->measureTabBar(this);
 }
 
+void TabBar::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(TabBar) - sizeof(Widget) + tabs_.capacity() * sizeof(TabButton *);
+	stats->eventHandlers += tabChangedCallbacks_.capacity() * sizeof(EventCallback);
+}
+
 void TabBar::setScrollValue(int value)
 {
 	const int oldValue = scrollValue_;
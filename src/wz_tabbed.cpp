@@ -37,6 +37,7 @@ TAB PAGE WIDGET
 TabPage::TabPage()
 {
 	type_ = WidgetType::TabPage;
+	setInputEvents(InputEvents::None);
 }
 
 void TabPage::add(Widget *widget)
@@ -67,6 +68,9 @@ Tab::Tab(const std::string &label, const std::string &icon)
 {
 	button_ = new TabButton(label, icon);
 	page_ = new TabPage();
+	pageFactory_ = NULL;
+	isPageCreated_ = true;
+	metadata_ = NULL;
 }
 
 Tab::~Tab()
@@ -94,6 +98,49 @@ void Tab::remove(Widget *widget)
 	page_->remove(widget);
 }
 
+void Tab::setPageFactory(TabPageFactory factory)
+{
+	pageFactory_ = factory;
+	isPageCreated_ = factory == NULL;
+}
+
+bool Tab::isPageCreated() const
+{
+	return isPageCreated_;
+}
+
+void Tab::setMetadata(void *metadata)
+{
+	metadata_ = metadata;
+}
+
+void *Tab::getMetadata()
+{
+	return metadata_;
+}
+
+void Tab::createPage()
+{
+	if (isPageCreated_)
+		return;
+
+	isPageCreated_ = true;
+	MainWindow *mainWindow = page_->getMainWindow();
+
+	// The factory may add hundreds of widgets, so only propagate dirty flags once.
+	if (mainWindow)
+	{
+		mainWindow->beginUpdate();
+	}
+
+	pageFactory_(this);
+
+	if (mainWindow)
+	{
+		mainWindow->endUpdate();
+	}
+}
+
 /*
 ================================================================================
 
@@ -105,6 +152,7 @@ TABBED WIDGET
 Tabbed::Tabbed()
 {
 	type_ = WidgetType::Tabbed;
+	setInputEvents(InputEvents::None);
 
 	layout_ = new StackLayout(StackLayoutDirection::Vertical);
 	layout_->setStretch(Stretch::All);
@@ -117,6 +165,7 @@ Tabbed::Tabbed()
 
 	pageContainer_ = new Widget;
 	pageContainer_->setStretch(Stretch::All);
+	pageContainer_->setInputEvents(InputEvents::None);
 	layout_->add(pageContainer_);
 }
 
@@ -141,10 +190,16 @@ void Tabbed::add(Tab *tab)
 	tabBar_->addTab(tab->button_);
 
 	// Add the page widget.
+	const bool selected = tabBar_->getSelectedTab() == tab->button_;
 	tab->page_->setStretch(Stretch::All);
-	tab->page_->setVisible(tabBar_->getSelectedTab() == tab->button_);
+	tab->page_->setVisible(selected);
 	pageContainer_->addChildWidget(tab->page_);
 
+	if (selected)
+	{
+		tab->createPage();
+	}
+
 	// Store this tab.
 	tabs_.push_back(tab);
 }
@@ -159,12 +214,27 @@ Size Tabbed::measure()
 	return renderer_->measureTabbed(this);
 }
 
+void Tabbed::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+
+	// The tabs aren't widgets, but the tabbed widget owns them.
+	stats->widgets += sizeof(Tabbed) - sizeof(Widget) + tabs_.capacity() * sizeof(Tab *) + tabs_.size() * sizeof(Tab);
+}
+
 void Tabbed::onTabChanged(Event e)
 {
 	// Set the corresponding page to visible, hide all the others.
 	for (size_t i = 0; i < tabs_.size(); i++)
 	{
-		tabs_[i]->page_->setVisible(tabs_[i]->button_ == e.tabBar.tab);
+		const bool selected = tabs_[i]->button_ == e.tabBar.tab;
+
+		if (selected)
+		{
+			tabs_[i]->createPage();
+		}
+
+		tabs_[i]->page_->setVisible(selected);
 	}
 }
 
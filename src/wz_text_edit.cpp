@@ -29,10 +29,13 @@ namespace wz {
 TextEdit::TextEdit(bool multiline, const std::string &text)
 {
 	type_ = WidgetType::TextEdit;
+	setInputEvents(InputEvents::MouseButtonDown | InputEvents::MouseButtonUp | InputEvents::MouseMove | InputEvents::MouseWheelMove | InputEvents::KeyDown | InputEvents::TextInput);
 	validateText_ = NULL;
 	pressed_ = false;
 	cursorIndex_ = scrollValue_ = 0;
 	selectionStartIndex_ = selectionEndIndex_ = 0;
+	boundText_ = NULL;
+	boundGeneration_ = 0;
 
 	if (multiline)
 	{
@@ -91,6 +94,7 @@ const char *TextEdit::getText() const
 void TextEdit::setText(const char *text)
 {
 	text_ = text;
+	updateBoundText();
 	setMeasureDirty();
 }
 
@@ -230,6 +234,18 @@ Position TextEdit::positionFromIndex(int index) const
 	return position;
 }
 
+void TextEdit::bindText(Bindable<std::string> *text)
+{
+	boundText_ = text;
+	setBound(text != NULL);
+
+	if (text)
+	{
+		boundGeneration_ = text->getGeneration();
+		setText(text->get().c_str());
+	}
+}
+
 void TextEdit::onRendererChanged()
 {
 	border_.left = border_.top = border_.right = border_.bottom = 4;
@@ -240,6 +256,15 @@ void TextEdit::onRectChanged()
 	updateScroller();
 }
 
+void TextEdit::refreshBinding()
+{
+	if (boundText_->getGeneration() == boundGeneration_)
+		return;
+
+	boundGeneration_ = boundText_->getGeneration();
+	setText(boundText_->get().c_str());
+}
+
 void TextEdit::onMouseButtonDown(int mouseButton, int mouseX, int mouseY)
 {
 	if (mouseButton == 1)
@@ -298,7 +323,7 @@ void TextEdit::onMouseButtonUp(int mouseButton, int /*mouseX*/, int /*mouseY*/)
 
 void TextEdit::onMouseMove(int mouseX, int mouseY, int /*mouseDeltaX*/, int /*mouseDeltaY*/)
 {
-	if (!(hover_ && WZ_POINT_IN_RECT(mouseX, mouseY, getTextRect())))
+	if (!(getHover() && WZ_POINT_IN_RECT(mouseX, mouseY, getTextRect())))
 		return;
 
 	mainWindow_->setCursor(Cursor::Ibeam);
@@ -523,6 +548,13 @@ Size TextEdit::measure()
 	return renderer_->measureTextEdit(this);
 }
 
+void TextEdit::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(TextEdit) - sizeof(Widget);
+	stats->strings += text_.capacity();
+}
+
 void TextEdit::onScrollerValueChanged(Event e)
 {
 	scrollValue_ = e.scroller.value;
@@ -594,6 +626,7 @@ void TextEdit::insertText(int index, const char *text, int n)
 {
 	WZ_ASSERT(text);
 	text_.insert(index, text, n);
+	updateBoundText();
 
 	// Update the scroller.
 	updateScroller();
@@ -624,6 +657,7 @@ void TextEdit::deleteText(int index, int n)
 		return;
 
 	text_.erase(index, n);
+	updateBoundText();
 
 	// Update the scroller.
 	updateScroller();
@@ -845,4 +879,13 @@ void TextEdit::moveCursorAndSelection(int newCursorIndex)
 	}
 }
 
+void TextEdit::updateBoundText()
+{
+	if (boundText_)
+	{
+		boundText_->set(text_);
+		boundGeneration_ = boundText_->getGeneration();
+	}
+}
+
 } // namespace wz
@@ -65,19 +65,20 @@ Widget::Widget()
 	stretchHeightScale_ = 0;
 	align_ = Align::None;
 	metadata_ = NULL;
-	flags_ = WidgetFlags::MeasureDirty | WidgetFlags::RectDirty;
-	hover_ = false;
-	visible_ = true;
-	ignore_ = false;
-	overlap_ = false;
-	drawManually_ = false;
-	inputClippedToParent_ = true;
+	flags_ = WidgetFlags::MeasureDirty | WidgetFlags::RectDirty | WidgetFlags::Visible | WidgetFlags::InputClippedToParent;
 	fontSize_ = 0;
-	fontFace_[0] = NULL;
+	fontFace_ = FontFaces::intern(NULL);
 	renderer_ = NULL;
 	mainWindow_ = NULL;
 	window_ = NULL;
 	parent_ = NULL;
+	childIndex_ = 0;
+	idHash_ = 0;
+	nextInIdBucket_ = NULL;
+	layoutIndex_ = -1;
+	inputEvents_ = InputEvents::All;
+	measureCacheSize_ = 0;
+	measureCacheNext_ = 0;
 }
 
 Widget::~Widget()
@@ -185,8 +186,17 @@ void Widget::setRect(Rect rect)
 {
 	if (rect != userRect_)
 	{
+		// Parent layouts measure children using the user size, if set.
+		const bool sizeChanged = rect.w != userRect_.w || rect.h != userRect_.h;
+
 		userRect_ = rect;
 		setRectDirty();
+
+		if (sizeChanged && parent_ && parent_->isLayoutWidget())
+		{
+			parent_->setMeasureDirty();
+		}
+
 		debugPrintf("user rect set (%i %i %i %i)", rect.x, rect.y, rect.w, rect.h);
 	}
 }
@@ -198,18 +208,7 @@ Rect Widget::getRect() const
 
 Rect Widget::getAbsoluteRect() const
 {
-	Rect rect = rect_;
-
-	if (parent_)
-	{
-		const Position parentPosition = parent_->getAbsolutePosition();
-		const Border parentPadding = parent_->getPadding();
-
-		rect.x += parentPosition.x + parentPadding.left;
-		rect.y += parentPosition.y + parentPadding.top;
-	}
-
-	return rect;
+	return absoluteRect_;
 }
 
 void Widget::setMargin(Border margin)
@@ -231,6 +230,15 @@ Border Widget::getMargin() const
 void Widget::setPadding(Border padding)
 {
 	padding_ = padding;
+
+	// Padding offsets the children, so their rects need recalculating.
+	flags_ = flags_ | WidgetFlags::ChildrenRectDirty;
+	setAncestorsFlag(WidgetFlags::DescendantRectDirty);
+
+	if (mainWindow_)
+	{
+		mainWindow_->setAnyWidgetRectDirty();
+	}
 }
 
 void Widget::setPadding(int top, int right, int bottom, int left)
@@ -284,7 +292,7 @@ int Widget::getAlign() const
 
 void Widget::setFontFace(const char *fontFace)
 {
-	strcpy(fontFace_, fontFace);
+	fontFace_ = FontFaces::intern(fontFace);
 	setMeasureDirty();
 	onFontChanged(fontFace_, fontSize_);
 }
@@ -308,7 +316,7 @@ float Widget::getFontSize() const
 
 void Widget::setFont(const char *fontFace, float fontSize)
 {
-	strcpy(fontFace_, fontFace);
+	fontFace_ = FontFaces::intern(fontFace);
 	fontSize_ = fontSize;
 	setMeasureDirty();
 	onFontChanged(fontFace_, fontSize_);
@@ -316,22 +324,75 @@ void Widget::setFont(const char *fontFace, float fontSize)
 
 bool Widget::getHover() const
 {
-	return hover_;
+	return hasFlag(WidgetFlags::Hover);
+}
+
+void Widget::setInputEvents(InputEvents::Enum events)
+{
+	if (events == inputEvents_)
+		return;
+
+	inputEvents_ = events;
+
+	// The main window keeps the events handled by each subtree with the layout order.
+	if (mainWindow_)
+	{
+		mainWindow_->setLayoutOrderDirty();
+	}
+}
+
+InputEvents::Enum Widget::getInputEvents() const
+{
+	return inputEvents_;
 }
 
 void Widget::setVisible(bool visible)
 {
-	if (visible_ == visible)
+	if (isVisible() == visible)
 		return;
 
-	visible_ = visible;
-	setRectDirty();
+	setFlag(WidgetFlags::Visible, visible);
+
+	// A parent layout only positions its visible children, so it needs to run again.
+	if (parent_ && parent_->isLayoutWidget())
+	{
+		parent_->markRectDirty();
+	}
+
+	// The measure and layout passes skip hidden subtrees, leaving their flags set. The layout pass also flags a hidden widget RectDirty if its parent changed. Catch up on anything that changed while this widget was hidden. If nothing did, the previous layout is still valid, e.g. switching back to a tab page.
+	if (visible)
+	{
+		if (isMeasureDirty())
+		{
+			setMeasureDirty();
+		}
+		else if (hasFlag(WidgetFlags::DescendantMeasureDirty))
+		{
+			setAncestorsFlag(WidgetFlags::DescendantMeasureDirty);
+
+			if (mainWindow_)
+			{
+				mainWindow_->setAnyWidgetMeasureDirty();
+			}
+		}
+
+		if ((flags_ & (WidgetFlags::RectDirty | WidgetFlags::DescendantRectDirty | WidgetFlags::ChildrenRectDirty)) != 0)
+		{
+			setAncestorsFlag(WidgetFlags::DescendantRectDirty);
+
+			if (mainWindow_)
+			{
+				mainWindow_->setAnyWidgetRectDirty();
+			}
+		}
+	}
+
 	onVisibilityChanged();
 }
 
 bool Widget::isVisible() const
 {
-	return visible_;
+	return hasFlag(WidgetFlags::Visible);
 }
 
 bool Widget::hasKeyboardFocus() const
@@ -354,6 +415,29 @@ const std::vector<Widget *> &Widget::getChildren() const
 	return children_;
 }
 
+void Widget::setId(const std::string &id)
+{
+	if (id == id_)
+		return;
+
+	if (mainWindow_ && !id_.empty())
+	{
+		mainWindow_->unregisterWidgetId(this);
+	}
+
+	id_ = id;
+
+	if (mainWindow_ && !id_.empty())
+	{
+		mainWindow_->registerWidgetId(this);
+	}
+}
+
+const std::string &Widget::getId() const
+{
+	return id_;
+}
+
 void Widget::setMetadata(void *metadata)
 {
 	metadata_ = metadata;
@@ -366,68 +450,129 @@ void *Widget::getMetadata()
 
 void Widget::addChildWidget(Widget *child)
 {
-	WZ_ASSERT(child);
-	children_.push_back(child);
-	child->parent_ = this;
-
-	// Set the main window to the ancestor main window.
-	child->mainWindow_ = findMainWindow();
+	addChildWidgetsInternal(&child, 1);
+}
 
-	// Set the renderer.
-	if (child->mainWindow_)
+void Widget::addChildWidgets(const std::vector<Widget *> &children)
+{
+	if (!children.empty())
 	{
-		child->setRenderer(child->mainWindow_->renderer_);
+		addChildWidgetsInternal(&children[0], children.size());
 	}
+}
 
-	// Set window to the closest ancestor window.
-	child->window_ = (Window *)findClosestAncestor(WidgetType::Window);
-
-	// Set children mainWindow, window and renderer.
-	child->setMainWindowAndWindowRecursive(child->mainWindow_, child->type_ == WidgetType::Window ? (Window *)child : child->window_);
+void Widget::addChildWidgetsInternal(Widget *const *children, size_t n)
+{
+	// The main window and closest ancestor window are the same for all the children.
+	MainWindow *mainWindow = mainWindow_;
+	Window *window = type_ == WidgetType::Window ? (Window *)this : window_;
+	bool anyMeasureDirty = false;
+	children_.reserve(children_.size() + n);
 
-	// If the widget is dirty, set the dirty flags on the main window.
-	if (child->mainWindow_)
+	for (size_t i = 0; i < n; i++)
 	{
-		if (child->isMeasureDirty())
+		Widget *child = children[i];
+		WZ_ASSERT(child);
+		child->parent_ = this;
+		child->childIndex_ = children_.size();
+		children_.push_back(child);
+		child->setMainWindow(mainWindow);
+		child->window_ = window;
+
+		// Set the renderer.
+		if (mainWindow)
 		{
-			child->mainWindow_->setAnyWidgetMeasureDirty();
+			child->setRenderer(mainWindow->renderer_);
 		}
 
-		if (child->isRectDirty())
+		// Set children mainWindow, window and renderer.
+		child->setMainWindowAndWindowRecursive(mainWindow, child->type_ == WidgetType::Window ? (Window *)child : window);
+
+		// If the child or any of its descendants need re-measuring, so does the child. A parent layout does too, unless the child is a relayout boundary. A parent flagged MeasuredFromChildren always does.
+		if ((child->flags_ & (WidgetFlags::MeasureDirty | WidgetFlags::DescendantMeasureDirty)) != 0)
 		{
-			child->mainWindow_->setAnyWidgetRectDirty();
+			child->flags_ = child->flags_ | WidgetFlags::MeasureDirty;
+			anyMeasureDirty = anyMeasureDirty || !child->isRelayoutBoundary() || hasFlag(WidgetFlags::MeasuredFromChildren);
 		}
+
+		// The child rect is relative to this widget, so it always needs recalculating.
+		child->flags_ = child->flags_ | WidgetFlags::RectDirty;
+	}
+
+	// Let this widget and its ancestors know about the dirty children.
+	flags_ = flags_ | WidgetFlags::DescendantMeasureDirty | WidgetFlags::DescendantRectDirty;
+	setAncestorsFlag(WidgetFlags::DescendantMeasureDirty);
+	setAncestorsFlag(WidgetFlags::DescendantRectDirty);
+
+	if (isLayoutWidget())
+	{
+		if (anyMeasureDirty)
+		{
+			setMeasureDirty();
+		}
+
+		markRectDirty();
+	}
+	else if (anyMeasureDirty && hasFlag(WidgetFlags::MeasuredFromChildren))
+	{
+		setMeasureDirty();
 	}
 
-	// Inform the child it now has a parent.
-	child->onParented(this);
+	if (mainWindow)
+	{
+		mainWindow->setLayoutOrderDirty();
+		mainWindow->setAnyWidgetMeasureDirty();
+		mainWindow->setAnyWidgetRectDirty();
+	}
+
+	// Inform the children they now have a parent.
+	for (size_t i = 0; i < n; i++)
+	{
+		children[i]->onParented(this);
+	}
 }
 
 void Widget::removeChildWidget(Widget *child)
 {
 	WZ_ASSERT(child);
 
-	// Remove from children.
-	int removeIndex = -1;
+	// Do nothing if not really a child, e.g. a widget added to a window is a child of the window content widget.
+	if (child->parent_ != this)
+		return;
+
+	// Remove from children, and shift the indices of the children after it.
+	const size_t removeIndex = child->childIndex_;
+	WZ_ASSERT(children_[removeIndex] == child);
+	children_.erase(children_.begin() + removeIndex);
 
-	for (size_t i = 0; i < children_.size(); i++)
+	for (size_t i = removeIndex; i < children_.size(); i++)
 	{
-		if (children_[i] == child)
-		{
-			removeIndex = (int)i;
-			break;
-		}
+		children_[i]->childIndex_ = i;
+	}
+
+	// A layout needs to re-measure and reposition the remaining children. A widget measured from its children needs re-measuring too.
+	if (isLayoutWidget() || hasFlag(WidgetFlags::MeasuredFromChildren))
+	{
+		setMeasureDirty();
 	}
 
-	if (removeIndex != -1)
+	if (child->mainWindow_)
 	{
-		children_.erase(children_.begin() + removeIndex);
+		child->mainWindow_->setLayoutOrderDirty();
 	}
 
 	// The child is no longer connected to the widget hierarchy, so reset some state.
-	child->mainWindow_ = NULL;
+	MainWindow *mainWindow = child->mainWindow_;
+	child->setMainWindow(NULL);
 	child->parent_ = NULL;
 	child->window_ = NULL;
+	child->setMainWindowAndWindowRecursive(NULL, child->type_ == WidgetType::Window ? (Window *)child : NULL);
+
+	// The child may be destroyed before the update scope ends.
+	if (mainWindow && mainWindow->isUpdating())
+	{
+		mainWindow->purgePendingDirtyWidgets();
+	}
 }
 
 void Widget::destroyChildWidget(Widget *child)
@@ -439,7 +584,17 @@ void Widget::destroyChildWidget(Widget *child)
 	if (n == children_.size())
 		return;
 
-	delete child;
+	// Delete the whole subtree. Widget destructors don't touch their children, so the order doesn't matter.
+	std::vector<Widget *> widgets;
+	widgets.push_back(child);
+
+	while (!widgets.empty())
+	{
+		Widget *widget = widgets.back();
+		widgets.pop_back();
+		widgets.insert(widgets.end(), widget->children_.begin(), widget->children_.end());
+		delete widget;
+	}
 }
 
 bool Widget::isRectDirty() const
@@ -459,12 +614,67 @@ Rect Widget::getUserRect() const
 
 Size Widget::getMeasuredSize() const
 {
+	// The measure pass skips hidden subtrees, so a widget may be asked for its size before it has been measured, e.g. tab bar buttons scrolled out of view. Measure it now.
+	if (isMeasureDirty() && renderer_)
+	{
+		Widget *widget = const_cast<Widget *>(this);
+
+		// Clear the flag before measuring, or a measure that reads its own measured size would recurse.
+		widget->setMeasureDirty(false);
+		widget->measuredSize_ = widget->measure();
+	}
+
 	return measuredSize_;
 }
 
+Size Widget::getMeasuredSize(int availableWidth, int availableHeight)
+{
+	for (int i = 0; i < measureCacheSize_; i++)
+	{
+		const MeasureCacheEntry &entry = measureCache_[i];
+
+		if (entry.availableWidth == availableWidth && entry.availableHeight == availableHeight)
+			return entry.size;
+	}
+
+	const Size size = measureConstrained(availableWidth, availableHeight);
+
+	// Add to the cache, replacing the oldest entry if it's full.
+	const int capacity = (int)(sizeof(measureCache_) / sizeof(measureCache_[0]));
+	int index;
+
+	if (measureCacheSize_ < capacity)
+	{
+		index = measureCacheSize_++;
+	}
+	else
+	{
+		index = measureCacheNext_;
+		measureCacheNext_ = (measureCacheNext_ + 1) % capacity;
+	}
+
+	measureCache_[index].availableWidth = availableWidth;
+	measureCache_[index].availableHeight = availableHeight;
+	measureCache_[index].size = size;
+	return size;
+}
+
 Size Widget::getUserOrMeasuredSize() const
 {
-	return Size(userRect_.w != 0 ? userRect_.w : measuredSize_.w, userRect_.h != 0 ? userRect_.h : measuredSize_.h);
+	if (userRect_.w != 0 && userRect_.h != 0)
+		return Size(userRect_.w, userRect_.h);
+
+	const Size measured = getMeasuredSize();
+	return Size(userRect_.w != 0 ? userRect_.w : measured.w, userRect_.h != 0 ? userRect_.h : measured.h);
+}
+
+Size Widget::getUserOrMeasuredSize(int availableWidth, int availableHeight)
+{
+	if (userRect_.w != 0 && userRect_.h != 0)
+		return Size(userRect_.w, userRect_.h);
+
+	const Size measured = getMeasuredSize(availableWidth, availableHeight);
+	return Size(userRect_.w != 0 ? userRect_.w : measured.w, userRect_.h != 0 ? userRect_.h : measured.h);
 }
 
 void Widget::setRectInternal(Rect rect)
@@ -473,6 +683,8 @@ void Widget::setRectInternal(Rect rect)
 		return;
 
 	rect_ = rect;
+	flags_ = flags_ | WidgetFlags::ChildrenRectDirty;
+	refreshAbsoluteRect();
 	debugPrintf("internal rect set (%i %i %i %i)", rect_.x, rect_.y, rect_.w, rect_.h);
 	onRectChanged();
 }
@@ -519,29 +731,22 @@ Widget *Widget::findClosestAncestor(WidgetType::Enum type)
 
 void Widget::setDrawManually(bool value)
 {
-	drawManually_ = value;
+	setFlag(WidgetFlags::DrawManually, value);
 }
 
 void Widget::setDrawLast(bool value)
 {
-	if (value)
-	{
-		flags_ = flags_ | WidgetFlags::DrawLast;
-	}
-	else
-	{
-		flags_ = WidgetFlags::Enum(flags_ & ~WidgetFlags::DrawLast);
-	}
+	setFlag(WidgetFlags::DrawLast, value);
 }
 
 bool Widget::getDrawLast() const
 {
-	return (flags_ & WidgetFlags::DrawLast) == WidgetFlags::DrawLast;
+	return hasFlag(WidgetFlags::DrawLast);
 }
 
 void Widget::setOverlap(bool value)
 {
-	overlap_ = value;
+	setFlag(WidgetFlags::Overlap, value);
 }
 
 bool Widget::overlapsParentWindow() const
@@ -554,7 +759,7 @@ bool Widget::overlapsParentWindow() const
 
 void Widget::setClipInputToParent(bool value)
 {
-	inputClippedToParent_ = value;
+	setFlag(WidgetFlags::InputClippedToParent, value);
 }
 
 Widget *Widget::addEventHandler(IEventHandler *eventHandler)
@@ -578,6 +783,18 @@ LineBreakResult Widget::lineBreakText(const char *text, int n, int lineWidth) co
 	return renderer_->lineBreakText(fontFace_, fontSize_, text, n, lineWidth);
 }
 
+void Widget::addMemoryStats(MemoryStats *stats) const
+{
+	stats->nWidgets++;
+	stats->widgets += sizeof(Widget) + children_.capacity() * sizeof(Widget *) + eventHandlers_.capacity() * sizeof(IEventHandler *);
+	stats->strings += id_.capacity();
+
+	for (size_t i = 0; i < eventHandlers_.size(); i++)
+	{
+		stats->eventHandlers += eventHandlers_[i]->getSize();
+	}
+}
+
 void Widget::doLayout() {}
 
 void Widget::onParented(Widget * /*parent*/) {}
@@ -588,6 +805,8 @@ void Widget::onFontChanged(const char * /*fontFace*/, float /*fontSize*/) {}
 
 void Widget::onVisibilityChanged() {}
 
+void Widget::refreshBinding() {}
+
 void Widget::onRectChanged() {}
 
 void Widget::onMouseButtonDown(int /*mouseButton*/, int /*mouseX*/, int /*mouseY*/) {}
@@ -620,26 +839,35 @@ Size Widget::measure()
 	return Size();
 }
 
+Size Widget::measureConstrained(int /*availableWidth*/, int /*availableHeight*/)
+{
+	return getMeasuredSize();
+}
+
 void Widget::setMeasureDirty(bool value)
 {
+	// Either the cached sizes are stale, or measuredSize_ has just been updated.
+	measureCacheSize_ = 0;
+	measureCacheNext_ = 0;
+
 	if (value)
 	{
 		flags_ = flags_ | WidgetFlags::MeasureDirty;
 
-		// A parent layout will need re-measuring too.
-		if (parent_ && parent_->isLayoutWidget())
+		// Defer propagation until the update scope ends.
+		if (mainWindow_ && mainWindow_->isUpdating())
 		{
-			parent_->setMeasureDirty();
-		}
+			if ((flags_ & (WidgetFlags::PendingMeasureDirty | WidgetFlags::PendingRectDirty)) == 0)
+			{
+				mainWindow_->addPendingDirtyWidget(this);
+			}
 
-		// Let the main window know that one of the widgets in its heirarchy need re-measuring.
-		if (mainWindow_)
+			flags_ = flags_ | WidgetFlags::PendingMeasureDirty;
+		}
+		else
 		{
-			mainWindow_->setAnyWidgetMeasureDirty();
+			propagateMeasureDirty();
 		}
-
-		// If we need to re-measure, we also need to recalculate the rect.
-		setRectDirty();
 	}
 	else
 	{
@@ -653,16 +881,19 @@ void Widget::setRectDirty(bool value)
 	{
 		flags_ = flags_ | WidgetFlags::RectDirty;
 
-		// A parent layout will need it's rect to be recalculated too.
-		if (parent_ && parent_->isLayoutWidget())
+		// Defer propagation until the update scope ends.
+		if (mainWindow_ && mainWindow_->isUpdating())
 		{
-			parent_->setRectDirty();
-		}
+			if ((flags_ & (WidgetFlags::PendingMeasureDirty | WidgetFlags::PendingRectDirty)) == 0)
+			{
+				mainWindow_->addPendingDirtyWidget(this);
+			}
 
-		// Let the main window know that one of the widgets in its heirarchy needs its rect recalculated.
-		if (mainWindow_)
+			flags_ = flags_ | WidgetFlags::PendingRectDirty;
+		}
+		else
 		{
-			mainWindow_->setAnyWidgetRectDirty();
+			propagateRectDirty();
 		}
 	}
 	else
@@ -671,26 +902,120 @@ void Widget::setRectDirty(bool value)
 	}
 }
 
-void Widget::doMeasurePassRecursive(bool dirty)
+void Widget::propagateMeasureDirty()
 {
-	for (size_t i = 0; i < children_.size(); i++)
+	// A parent layout will need re-measuring too, unless this widget is a relayout boundary. A parent flagged MeasuredFromChildren reads the measured size, not the user size, so a boundary doesn't stop it.
+	const bool boundary = isRelayoutBoundary();
+
+	if (parent_ && (parent_->isLayoutWidget() ? !boundary : parent_->hasFlag(WidgetFlags::MeasuredFromChildren)))
+	{
+		parent_->setMeasureDirty();
+	}
+
+	// Let the ancestors know so the measure pass doesn't skip this widget.
+	setAncestorsFlag(WidgetFlags::DescendantMeasureDirty);
+
+	// Let the main window know that one of the widgets in its heirarchy need re-measuring.
+	if (mainWindow_)
 	{
-		children_[i]->doMeasurePassRecursive(dirty || children_[i]->isMeasureDirty());
+		mainWindow_->setAnyWidgetMeasureDirty();
 	}
 
-	if (dirty)
+	// If we need to re-measure, we also need to recalculate the rect. A relayout boundary keeps the same rect, so the parent layout doesn't need to run.
+	if (boundary)
 	{
-		measuredSize_ = measure();
-		setMeasureDirty(false);
+		markRectDirty();
 	}
+	else
+	{
+		setRectDirty();
+	}
+}
+
+void Widget::propagateRectDirty()
+{
+	markRectDirty();
+
+	// A parent layout will need to run its layout logic. The parent layout rect only depends on its measured size, which setMeasureDirty takes care of, so there's no need to go any further.
+	if (parent_ && parent_->isLayoutWidget())
+	{
+		parent_->markRectDirty();
+	}
+}
+
+void Widget::markRectDirty()
+{
+	flags_ = flags_ | WidgetFlags::RectDirty;
+
+	// Let the ancestors know so the layout pass doesn't skip this widget.
+	setAncestorsFlag(WidgetFlags::DescendantRectDirty);
+
+	// Let the main window know that one of the widgets in its heirarchy needs its rect recalculated.
+	if (mainWindow_)
+	{
+		mainWindow_->setAnyWidgetRectDirty();
+	}
+}
+
+bool Widget::isRelayoutBoundary() const
+{
+	return userRect_.w != 0 && userRect_.h != 0;
 }
 
-void Widget::doLayoutPassRecursive(bool dirty)
+bool Widget::hasFlag(WidgetFlags::Enum flag) const
 {
-	if (!visible_)
+	return (flags_ & flag) != 0;
+}
+
+void Widget::setBound(bool bound)
+{
+	if (hasFlag(WidgetFlags::Bound) == bound)
 		return;
 
-	if (dirty && (!parent_ || !parent_->isLayoutWidget()))
+	setFlag(WidgetFlags::Bound, bound);
+
+	if (!mainWindow_)
+		return;
+
+	if (bound)
+	{
+		mainWindow_->registerBoundWidget(this);
+	}
+	else
+	{
+		mainWindow_->unregisterBoundWidget(this);
+	}
+}
+
+void Widget::setFlag(WidgetFlags::Enum flag, bool value)
+{
+	if (value)
+	{
+		flags_ = flags_ | flag;
+	}
+	else
+	{
+		flags_ = WidgetFlags::Enum(flags_ & ~flag);
+	}
+}
+
+void Widget::setAncestorsFlag(WidgetFlags::Enum flag)
+{
+	for (Widget *widget = parent_; widget && (widget->flags_ & flag) == 0; widget = widget->parent_)
+	{
+		widget->flags_ = widget->flags_ | flag;
+	}
+}
+
+bool Widget::doLayoutPass(bool dirty)
+{
+	// Used to detect if an ancestor has moved.
+	const Rect oldAbsoluteRect = absoluteRect_;
+
+	// Layout children have their rect set by the parent layout.
+	const bool recalculate = dirty || isRectDirty();
+
+	if (recalculate && (!parent_ || !parent_->isLayoutWidget()))
 	{
 		// Calculate new size.
 		const Rect parentRect = parent_ ? parent_->getRect() : Rect();
@@ -711,7 +1036,7 @@ void Widget::doLayoutPassRecursive(bool dirty)
 		else
 		{
 			// Width is measured (default).
-			newRect.w = measuredSize_.w;
+			newRect.w = getMeasuredSize().w;
 		}
 
 		if (userRect_.h != 0)
@@ -727,8 +1052,8 @@ void Widget::doLayoutPassRecursive(bool dirty)
 		}
 		else
 		{
-			// Height is measured (default).
-			newRect.h = measuredSize_.h;
+			// Height is measured (default), and may depend on the width.
+			newRect.h = getMeasuredSize(newRect.w, 0).h;
 		}
 
 		// Calculate new position.
@@ -790,19 +1115,40 @@ void Widget::doLayoutPassRecursive(bool dirty)
 		setRectInternal(newRect);
 	}
 
+	// The rect may not have changed, but an ancestor's may have.
+	refreshAbsoluteRect();
+
 	// Done, rect is no longer dirty.
 	setRectDirty(false);
 
+	// If the rect, padding or absolute position has changed, all the children need their rects recalculated. Otherwise only visit the dirty ones.
+	const bool childrenDirty = (flags_ & WidgetFlags::ChildrenRectDirty) != 0 || absoluteRect_ != oldAbsoluteRect;
+	flags_ = WidgetFlags::Enum(flags_ & ~(WidgetFlags::DescendantRectDirty | WidgetFlags::ChildrenRectDirty));
+
 	// Have layout widgets run their layout logic.
-	if (isLayoutWidget())
+	if (isLayoutWidget() && (recalculate || childrenDirty))
 	{
 		doLayout();
 	}
 
-	// Recurse into children.
-	for (size_t i = 0; i < children_.size(); i++)
+	return childrenDirty;
+}
+
+void Widget::refreshAbsoluteRect()
+{
+	const Rect oldAbsoluteRect = absoluteRect_;
+	absoluteRect_ = rect_;
+
+	if (parent_)
 	{
-		children_[i]->doLayoutPassRecursive(dirty || children_[i]->isRectDirty());
+		const Rect parentRect = parent_->absoluteRect_;
+		absoluteRect_.x += parentRect.x + parent_->padding_.left;
+		absoluteRect_.y += parentRect.y + parent_->padding_.top;
+	}
+
+	if (mainWindow_ && absoluteRect_ != oldAbsoluteRect)
+	{
+		mainWindow_->updateHitRect(this);
 	}
 }
 
@@ -838,32 +1184,52 @@ void Widget::invokeEvent(Event e, const std::vector<EventCallback> &callbacks)
 	}
 }
 
-MainWindow *Widget::findMainWindow()
+void Widget::setRenderer(IRenderer *renderer)
 {
-	Widget *widget = this;
+	IRenderer *oldRenderer = renderer_;
+	renderer_ = renderer;
 
-	for (;;)
+	if (oldRenderer != renderer_)
 	{
-		if (!widget)
-			break;
+		onRendererChanged();
+	}
+}
 
-		if (widget->type_ == WidgetType::MainWindow)
-			return (MainWindow *)widget;
+void Widget::setMainWindow(MainWindow *mainWindow)
+{
+	if (mainWindow == mainWindow_)
+		return;
 
-		widget = widget->parent_;
+	if (mainWindow_ && !id_.empty())
+	{
+		mainWindow_->unregisterWidgetId(this);
 	}
 
-	return NULL;
-}
+	if (mainWindow_ && hasFlag(WidgetFlags::Bound))
+	{
+		mainWindow_->unregisterBoundWidget(this);
+	}
 
-void Widget::setRenderer(IRenderer *renderer)
-{
-	IRenderer *oldRenderer = renderer_;
-	renderer_ = renderer;
+	if (mainWindow_ && hasFlag(WidgetFlags::Hover))
+	{
+		mainWindow_->unregisterHoverWidget(this);
+	}
 
-	if (oldRenderer != renderer_)
+	if (mainWindow_ && hasFlag(WidgetFlags::Captured))
 	{
-		onRendererChanged();
+		mainWindow_->unregisterCaptureWidget(this);
+	}
+
+	mainWindow_ = mainWindow;
+
+	if (mainWindow_ && !id_.empty())
+	{
+		mainWindow_->registerWidgetId(this);
+	}
+
+	if (mainWindow_ && hasFlag(WidgetFlags::Bound))
+	{
+		mainWindow_->registerBoundWidget(this);
 	}
 }
 
@@ -874,7 +1240,7 @@ void Widget::setMainWindowAndWindowRecursive(MainWindow *mainWindow, Window *win
 	for (size_t i = 0; i < children_.size(); i++)
 	{
 		Widget *child = children_[i];
-		child->mainWindow_ = mainWindow;
+		child->setMainWindow(mainWindow);
 		child->window_ = window;
 
 		// Set the renderer too.
@@ -892,69 +1258,76 @@ void Widget::debugPrintf(const char *, ...) const
 {
 }
 #else
-static void DebugVPrint(const char *format, va_list args)
-{
-	char buffer[128];
-	vsnprintf(buffer, sizeof(buffer), format, args);
-	va_end(args);
+// Append to the line being built. Each line is output with a single call, so lines from main windows on different threads don't interleave. The line is a fixed size buffer on the stack, so printing doesn't allocate, and long lines are truncated.
+static const size_t debugLineSize = 1024;
 
-#ifdef _MSC_VER
-	OutputDebugString(buffer);
-#else
-	printf("%s", buffer);	
-#endif
+static void DebugAppendV(char *line, const char *format, va_list args)
+{
+	const size_t length = strlen(line);
+	vsnprintf(line + length, debugLineSize - length, format, args);
 }
 
-static void DebugPrintf(const char *format, ...)
+static void DebugAppend(char *line, const char *format, ...)
 {
 	va_list args;
 	va_start(args, format);
-	DebugVPrint(format, args);
+	DebugAppendV(line, format, args);
+	va_end(args);
 }
 
 void Widget::debugPrintf(const char *format, ...) const
 {
-	debugPrintWidgetDetailsRecursive();
+	// Leave room for the newline.
+	char line[debugLineSize + 1];
+	line[0] = 0;
+	debugPrintWidgetDetailsRecursive(line);
 
-	DebugPrintf(": ");
+	DebugAppend(line, ": ");
 
 	va_list args;
 	va_start(args, format);
-	DebugVPrint(format, args);
+	DebugAppendV(line, format, args);
+	va_end(args);
 
-	DebugPrintf("\n");
+	strcat(line, "\n");
+
+#ifdef _MSC_VER
+	OutputDebugString(line);
+#else
+	fputs(line, stdout);
+#endif
 }
 
-void Widget::debugPrintWidgetDetailsRecursive() const
+void Widget::debugPrintWidgetDetailsRecursive(char *line) const
 {
 	if (parent_)
 	{
-		parent_->debugPrintWidgetDetailsRecursive();
-		DebugPrintf(" -> ");
+		parent_->debugPrintWidgetDetailsRecursive(line);
+		DebugAppend(line, " -> ");
 	}
 
-	DebugPrintf(widgetTypeNames[(int)type_]);
+	DebugAppend(line, widgetTypeNames[(int)type_]);
 
 	// Try to print a description for the widget too.
 	if (type_ == WidgetType::Window && ((Window *)this)->getTitle()[0])
 	{
-		DebugPrintf(" \"%s\"", ((Window *)this)->getTitle());
+		DebugAppend(line, " \"%s\"", ((Window *)this)->getTitle());
 	}
 	else if ((type_ == WidgetType::Button || type_ == WidgetType::CheckBox || type_ == WidgetType::RadioButton) && ((Button *)this)->getLabel()[0])
 	{
-		DebugPrintf(" \"%s\"", ((Button *)this)->getLabel());
+		DebugAppend(line, " \"%s\"", ((Button *)this)->getLabel());
 	}
 	else if (type_ == WidgetType::GroupBox && ((GroupBox *)this)->getLabel()[0])
 	{
-		DebugPrintf(" \"%s\"", ((GroupBox *)this)->getLabel());
+		DebugAppend(line, " \"%s\"", ((GroupBox *)this)->getLabel());
 	}
 	else if (type_ == WidgetType::Label && !((Label *)this)->getMultiline())
 	{
-		DebugPrintf(" \"%s\"", ((Label *)this)->getText());
+		DebugAppend(line, " \"%s\"", ((Label *)this)->getText());
 	}
 	else if (type_ == WidgetType::MenuBarButton && ((MenuBarButton *)this)->getLabel()[0])
 	{
-		DebugPrintf(" \"%s\"", ((MenuBarButton *)this)->getLabel());
+		DebugAppend(line, " \"%s\"", ((MenuBarButton *)this)->getLabel());
 	}
 }
 #endif
@@ -31,6 +31,7 @@ namespace wz {
 Window::Window(const std::string &title)
 {
 	type_ = WidgetType::Window;
+	setInputEvents(InputEvents::MouseButtonDown | InputEvents::MouseButtonUp | InputEvents::MouseMove);
 	drawPriority_ = 0;
 	headerHeight_ = 0;
 	borderSize_ = 4;
@@ -39,6 +40,7 @@ Window::Window(const std::string &title)
 
 	content_ = new Widget;
 	content_->setStretch(Stretch::All);
+	content_->setInputEvents(InputEvents::None);
 	addChildWidget(content_);
 }
 
@@ -346,10 +348,17 @@ Size Window::measure()
 	return renderer_->measureWindow(this);
 }
 
+void Window::addMemoryStats(MemoryStats *stats) const
+{
+	Widget::addMemoryStats(stats);
+	stats->widgets += sizeof(Window) - sizeof(Widget);
+	stats->strings += title_.capacity();
+}
+
 void Window::refreshHeaderHeightAndPadding()
 {
 	headerHeight_ = getLineHeight() + 6; // Padding.
-	padding_ = Border(borderSize_ + headerHeight_, borderSize_, borderSize_, borderSize_);
+	setPadding(Border(borderSize_ + headerHeight_, borderSize_, borderSize_, borderSize_));
 }
 
 void Window::calculateBorderRects(Rect *rects)